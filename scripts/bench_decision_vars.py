@@ -0,0 +1,130 @@
+import os
+import re
+import subprocess
+import shlex
+import time
+import logging
+import resource
+from colorama import init, Fore
+
+# Compare the planner with and without -decisionOpsOnly (the solver does not branch on the facts that
+# the op and ordering variables determine) on the partial order domains of the IPC 2023.
+# Reports, for each problem and configuration, the total time, the number of decisions and
+# conflicts of the solver (as printed by the glucose IPASIR glue on release) and the layer of the plan.
+
+TIMEOUT_S = 300
+MEMORY_LIMIT_GB = 25
+MEMORY_LIMIT_BYTES = MEMORY_LIMIT_GB * 1024 * 1024 * 1024
+
+
+def set_memory_limit():
+    try:
+        resource.setrlimit(resource.RLIMIT_AS, (MEMORY_LIMIT_BYTES, MEMORY_LIMIT_BYTES))
+    except Exception as e:
+        logging.error(f"Failed to set memory limit: {e}")
+
+
+PATH_BENCHMARKS = [
+    ("Benchmarks/ipc2023-domains/partial-order/Transport", 15),
+    ("Benchmarks/ipc2023-domains/partial-order/Barman-BDI", 2),
+    ("Benchmarks/ipc2023-domains/partial-order/Rover", 10),
+    ("Benchmarks/ipc2023-domains/partial-order/Satellite", 20),
+    ("Benchmarks/ipc2023-domains/partial-order/UM-Translog", 10),
+    ("Benchmarks/ipc2023-domains/partial-order/PCP", 1),
+    ("Benchmarks/ipc2023-domains/partial-order/Woodworking", 10),
+]
+
+CONFIGS = [
+    ("all vars", "./build/sibylsat-po {domain_path} {problem_path} -po -sibylsat -vp=1"),
+    ("ops only", "./build/sibylsat-po {domain_path} {problem_path} -po -sibylsat -vp=1 -decisionOpsOnly=1"),
+]
+
+
+def find_domain_file(problem_file, domain_files):
+    if "domain.hddl" in domain_files:
+        return "domain.hddl"
+    domain_file_name = problem_file.split('.')[0] + "-domain.hddl"
+    if domain_file_name in domain_files:
+        return domain_file_name
+    return None
+
+
+def sum_solver_stat(output, name):
+    # e.g. "c [glucose4]    decisions        12345   678.9 per second"
+    total = 0
+    for match in re.finditer(r"^c \[[^\]]*\]\s+" + name + r"\s+(\d+)", output, re.MULTILINE):
+        total += int(match.group(1))
+    return total
+
+
+def run(command):
+    start = time.time()
+    try:
+        output = subprocess.run(
+            shlex.split(command),
+            check=False,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            universal_newlines=True,
+            timeout=TIMEOUT_S,
+            preexec_fn=set_memory_limit
+        )
+    except subprocess.TimeoutExpired:
+        return None
+    elapsed = time.time() - start
+    out = output.stdout
+    if output.returncode != 0 or "Plan has been verified by pandaPIparser" not in out:
+        return None
+    layer = re.search(r"Found a solution at layer (\d+)", out)
+    return {
+        "time": elapsed,
+        "decisions": sum_solver_stat(out, "decisions"),
+        "conflicts": sum_solver_stat(out, "conflicts"),
+        "layer": int(layer.group(1)) if layer else -1,
+    }
+
+
+if __name__ == "__main__":
+
+    init(autoreset=True)
+    logging.basicConfig(format='%(asctime)s %(levelname)s:%(message)s', level=logging.INFO)
+
+    totals = {name: {"time": 0.0, "decisions": 0, "conflicts": 0, "solved": 0} for name, _ in CONFIGS}
+
+    print(f"{'problem':40s} " + " ".join(f"{name + ' (s/dec/confl)':>36s}" for name, _ in CONFIGS))
+    for (path_benchmark, highest_instance_to_solve) in PATH_BENCHMARKS:
+        name_benchmark = path_benchmark.split('/')[-1]
+        if not os.path.isdir(path_benchmark):
+            logging.warning(f"{Fore.YELLOW}Benchmark {name_benchmark} not found ({path_benchmark}){Fore.RESET}")
+            continue
+
+        files_in_benchmark = sorted(f for f in os.listdir(path_benchmark) if f.endswith("hddl") or f.endswith("pddl"))
+        domain_files = [f for f in files_in_benchmark if "domain" in f.lower() and f.endswith("hddl")]
+        problem_files = [f for f in files_in_benchmark if "domain" not in f.lower()]
+        full_path_benchmark = os.path.abspath(path_benchmark)
+
+        for problem_file in problem_files[:highest_instance_to_solve]:
+            domain_file = find_domain_file(problem_file, domain_files)
+            if domain_file is None:
+                logging.error(f"{Fore.RED}No domain file for {name_benchmark}/{problem_file}{Fore.RESET}")
+                continue
+
+            cells = []
+            for name, config in CONFIGS:
+                command = config.format(domain_path=os.path.join(full_path_benchmark, domain_file),
+                                        problem_path=os.path.join(full_path_benchmark, problem_file))
+                result = run(command)
+                if result is None:
+                    cells.append(f"{'FAIL':>36s}")
+                    continue
+                totals[name]["time"] += result["time"]
+                totals[name]["decisions"] += result["decisions"]
+                totals[name]["conflicts"] += result["conflicts"]
+                totals[name]["solved"] += 1
+                cells.append(f"{result['time']:10.2f} {result['decisions']:12d} {result['conflicts']:12d}")
+            print(f"{name_benchmark + '/' + problem_file:40s} " + " ".join(cells), flush=True)
+
+    print()
+    for name, _ in CONFIGS:
+        total = totals[name]
+        print(f"{name:10s} solved {total['solved']:4d}  time {total['time']:10.2f} s  decisions {total['decisions']:14d}  conflicts {total['conflicts']:14d}")
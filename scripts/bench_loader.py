@@ -0,0 +1,89 @@
+import os
+import subprocess
+import sys
+import logging
+from colorama import init, Fore
+
+# Benchmark of the loading of the grounded problems (./build/load_bench) on the biggest problems of
+# the IPC 2023 domains. Each problem is parsed and grounded once with the pandaPI tools of lib/, into
+# ProblemProcessing/bench_loader/, then loaded with 1, 2, 4... up to MAX_THREADS threads (-loadThreads).
+# Usage: python3 scripts/bench_loader.py [max_threads]
+
+NUM_BIGGEST_PROBLEMS = 3
+MAX_THREADS = int(sys.argv[1]) if len(sys.argv) > 1 else 8
+REPETITIONS = 3
+GROUNDED_DIR = "ProblemProcessing/bench_loader"
+
+PATH_BENCHMARKS = [
+    "Benchmarks/ipc2023-domains/partial-order/Transport",
+    "Benchmarks/ipc2023-domains/partial-order/Barman-BDI",
+    "Benchmarks/ipc2023-domains/partial-order/Rover",
+    "Benchmarks/ipc2023-domains/partial-order/Satellite",
+    "Benchmarks/ipc2023-domains/partial-order/UM-Translog",
+    "Benchmarks/ipc2023-domains/partial-order/Woodworking",
+    "Benchmarks/ipc2023-domains/total-order/Transport",
+    "Benchmarks/ipc2023-domains/total-order/Rover",
+    "Benchmarks/ipc2023-domains/total-order/Satellite",
+]
+
+
+def find_domain_file(problem_file, domain_files):
+    if "domain.hddl" in domain_files:
+        return "domain.hddl"
+    domain_file_name = problem_file.split('.')[0] + "-domain.hddl"
+    if domain_file_name in domain_files:
+        return domain_file_name
+    return None
+
+
+def ground(domain_path, problem_path, grounded_path):
+    if os.path.exists(grounded_path):
+        return True
+    parsed_path = grounded_path + ".parsed"
+    try:
+        subprocess.run(["lib/pandaPIparser", domain_path, problem_path, parsed_path], check=True,
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        subprocess.run(["lib/pandaPIgrounder", "--invariants", parsed_path, grounded_path], check=True,
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    except subprocess.CalledProcessError:
+        return False
+    finally:
+        if os.path.exists(parsed_path):
+            os.remove(parsed_path)
+    return True
+
+
+if __name__ == "__main__":
+
+    init(autoreset=True)
+    logging.basicConfig(format='%(asctime)s %(levelname)s:%(message)s', level=logging.INFO)
+    os.makedirs(GROUNDED_DIR, exist_ok=True)
+
+    for path_benchmark in PATH_BENCHMARKS:
+        name_benchmark = path_benchmark.split('/')[-2] + "/" + path_benchmark.split('/')[-1]
+        if not os.path.isdir(path_benchmark):
+            logging.warning(f"{Fore.YELLOW}Benchmark {name_benchmark} not found ({path_benchmark}){Fore.RESET}")
+            continue
+
+        files_in_benchmark = sorted(f for f in os.listdir(path_benchmark) if f.endswith("hddl") or f.endswith("pddl"))
+        domain_files = [f for f in files_in_benchmark if "domain" in f.lower() and f.endswith("hddl")]
+        problem_files = [f for f in files_in_benchmark if "domain" not in f.lower()]
+        # The biggest problem files give the biggest groundings
+        problem_files.sort(key=lambda f: os.path.getsize(os.path.join(path_benchmark, f)), reverse=True)
+
+        for problem_file in problem_files[:NUM_BIGGEST_PROBLEMS]:
+            domain_file = find_domain_file(problem_file, domain_files)
+            if domain_file is None:
+                logging.error(f"{Fore.RED}No domain file for {name_benchmark}/{problem_file}{Fore.RESET}")
+                continue
+
+            grounded_path = os.path.join(GROUNDED_DIR, name_benchmark.replace('/', '_') + "_" + problem_file + ".grounded")
+            if not ground(os.path.join(path_benchmark, domain_file), os.path.join(path_benchmark, problem_file), grounded_path):
+                logging.error(f"{Fore.RED}Grounding of {name_benchmark}/{problem_file} failed{Fore.RESET}")
+                continue
+
+            size_mb = os.path.getsize(grounded_path) / (1024 * 1024)
+            print(f"{name_benchmark}/{problem_file} ({size_mb:.1f} MB grounded)", flush=True)
+            output = subprocess.run(["./build/load_bench", grounded_path, str(MAX_THREADS), str(REPETITIONS)],
+                                    stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, universal_newlines=True)
+            print(output.stdout, flush=True)
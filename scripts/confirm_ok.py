@@ -3,6 +3,7 @@ import subprocess
 import logging
 import shlex
 import time
+import itertools
 import resource # Added for memory limiting
 from colorama import init, Fore
 
@@ -48,6 +49,17 @@ PATH_BENCHMARKS = [
 
 planner_config = "./build/sibylsat-po {domain_path} {problem_path} -po -sibylsat"
 
+# Options added to planner_config, each configuration is tested on all the benchmarks
+PLANNER_OPTIONS = [
+    "",
+    # Next layer encoded while solving, with the transitivity clauses added lazily
+    "-pipeline=1 -lazyTransitivity=1",
+    # Frame axioms of the facts unchanged by a unique previous node replaced by equalities
+    "-factAliasing=1",
+    # Rigid and irrelevant predicates removed after grounding
+    "-simplifyPreds=1",
+]
+
 
 if __name__ == "__main__":
 
@@ -68,16 +80,16 @@ if __name__ == "__main__":
 
     number_instances_checked = 0
 
-    number_of_benchmarks = len(PATH_BENCHMARKS)
+    number_of_benchmarks = len(PLANNER_OPTIONS) * len(PATH_BENCHMARKS)
     idx_benchmark = 0
 
-    for (path_benchmark, highest_instance_to_solve) in PATH_BENCHMARKS:
+    for (options, (path_benchmark, highest_instance_to_solve)) in itertools.product(PLANNER_OPTIONS, PATH_BENCHMARKS):
 
         idx_benchmark += 1
 
         name_benchmark = path_benchmark.split('/')[-1]
         logging.info(
-            f"Test benchmark {name_benchmark} ({idx_benchmark}/{number_of_benchmarks})")
+            f"Test benchmark {name_benchmark} with options '{options}' ({idx_benchmark}/{number_of_benchmarks})")
         
 
         # Load all the problems
@@ -113,7 +125,7 @@ if __name__ == "__main__":
                     exit(1)
 
             # Launch planner to test is OK
-            command = planner_config.format(domain_path=os.path.join(full_path_benchmark, domain_file_name), problem_path=os.path.join(full_path_benchmark, files_in_benchmark[i]))
+            command = (planner_config + " " + options).format(domain_path=os.path.join(full_path_benchmark, domain_file_name), problem_path=os.path.join(full_path_benchmark, files_in_benchmark[i]))
             print(command)
             try:
                 # Execute the command with timeout and memory limit
@@ -0,0 +1,74 @@
+import os
+import socket
+import sys
+import argparse
+from concurrent.futures import ThreadPoolExecutor
+
+# Client of the planner server (./build/sibylsat-po [domain] -server=<socket>, see src/algo/planner_server.h).
+# Sends one request per problem (concurrently with -j), prints the plans and exits with 1 if any request failed.
+# Usage: python3 scripts/planner_client.py <socket> <problem>... [--domain D] [--text] [-j N] [-- planner options]
+# Without --domain, the domain of the server is used. With --text, the contents of the files are sent
+# instead of their paths (the server may then run on another file system).
+
+
+def send_request(socket_path, domain, problem, text, options):
+    if text:
+        domain_text = open(domain, "rb").read() if domain else b""
+        problem_text = open(problem, "rb").read()
+        header = "TEXT %s %d" % (len(domain_text) if domain else "-", len(problem_text))
+        payload = domain_text + problem_text
+    else:
+        header = "FILES %s %s" % (os.path.abspath(domain) if domain else "-", os.path.abspath(problem))
+        payload = b""
+    if options:
+        header += " " + " ".join(options)
+
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(socket_path)
+        sock.sendall(header.encode() + b"\n" + payload)
+        response = b""
+        while True:
+            data = sock.recv(1 << 16)
+            if not data:
+                break
+            response += data
+
+    status, _, rest = response.partition(b"\n")
+    if not status:
+        return False, "No response from the server"
+    kind, _, length = status.decode().partition(" ")
+    return kind == "OK", rest[: int(length)].decode(errors="replace")
+
+
+def main():
+    argv = sys.argv[1:]
+    options = []
+    if "--" in argv:
+        options = argv[argv.index("--") + 1 :]
+        argv = argv[: argv.index("--")]
+
+    parser = argparse.ArgumentParser(description="Client of the planner server")
+    parser.add_argument("socket", help="Unix socket of the server")
+    parser.add_argument("problems", nargs="+", help="Problem files")
+    parser.add_argument("--domain", help="Domain file (default: the domain of the server)")
+    parser.add_argument("--text", action="store_true", help="Send the contents of the files instead of their paths")
+    parser.add_argument("-j", type=int, default=1, help="Number of concurrent requests")
+    args = parser.parse_args(argv)
+
+    with ThreadPoolExecutor(max_workers=args.j) as executor:
+        futures = [
+            executor.submit(send_request, args.socket, args.domain, problem, args.text, options)
+            for problem in args.problems
+        ]
+        all_ok = True
+        for problem, future in zip(args.problems, futures):
+            ok, body = future.result()
+            all_ok = all_ok and ok
+            print("### %s: %s" % (problem, "OK" if ok else "FAIL"))
+            print(body)
+
+    sys.exit(0 if all_ok else 1)
+
+
+if __name__ == "__main__":
+    main()
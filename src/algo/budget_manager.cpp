@@ -0,0 +1,111 @@
+#include "algo/budget_manager.h"
+
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+#include "util/log.h"
+#include "util/timer.h"
+
+// Minimum time between two memory measurements in the terminate callback (seconds)
+const double MEMORY_CHECK_PERIOD = 0.1;
+
+BudgetManager::BudgetManager(Parameters &params) : _time_limit(params.getFloatParam("T")),
+                                                   _solve_time_limit(params.getFloatParam("solveT")),
+                                                   _solve_time_growth(params.getFloatParam("solveTGrowth")),
+                                                   _memory_limit_mb(params.getIntParam("mem")),
+                                                   _max_depth(params.getIntParam("maxDepth"))
+{
+}
+
+void BudgetManager::beginLayer(int depth)
+{
+    if (_solve_time_limit <= 0)
+        return;
+    _layer_solve_time_limit = _solve_time_limit * std::pow(std::max(1.0, (double)_solve_time_growth), depth - 1);
+    Log::i("  Time limit of each solve call of layer %d: %.3f s\n", depth, _layer_solve_time_limit);
+}
+
+void BudgetManager::beginSolve()
+{
+    if (_solve_time_limit <= 0)
+        return;
+    _solve_deadline = Timer::elapsedSeconds() + _layer_solve_time_limit;
+}
+
+bool BudgetManager::canContinue(int depth)
+{
+    if (depth > _max_depth)
+        _stop_reason = StopReason::MAX_DEPTH;
+    else if (isOutOfTime())
+        _stop_reason = StopReason::TIME;
+    else if (isOutOfMemory())
+        _stop_reason = StopReason::MEMORY;
+    else
+        return true;
+    return false;
+}
+
+std::string BudgetManager::getStopReason() const
+{
+    char reason[64];
+    switch (_stop_reason)
+    {
+    case StopReason::MAX_DEPTH:
+        snprintf(reason, sizeof(reason), "maximum depth %d reached", _max_depth);
+        break;
+    case StopReason::TIME:
+        snprintf(reason, sizeof(reason), "time limit of %g s reached", _time_limit);
+        break;
+    case StopReason::MEMORY:
+        snprintf(reason, sizeof(reason), "memory limit of %ld MB reached", _memory_limit_mb);
+        break;
+    default:
+        return "";
+    }
+    return reason;
+}
+
+int BudgetManager::terminate(void *state)
+{
+    BudgetManager *budget = static_cast<BudgetManager *>(state);
+    if (budget->isOutOfTime())
+        return 1;
+    if (budget->_solve_time_limit > 0 && Timer::elapsedSeconds() > budget->_solve_deadline)
+        return 1;
+    if (budget->_memory_limit_mb > 0)
+    {
+        // Reading the memory usage is much more expensive than reading the clock
+        double now = Timer::elapsedSeconds();
+        double last_check = budget->_last_memory_check;
+        if (now - last_check > MEMORY_CHECK_PERIOD && budget->_last_memory_check.compare_exchange_strong(last_check, now))
+            budget->isOutOfMemory();
+        return budget->_out_of_memory;
+    }
+    return 0;
+}
+
+bool BudgetManager::isOutOfTime() const
+{
+    return _time_limit > 0 && Timer::elapsedSeconds() > _time_limit;
+}
+
+bool BudgetManager::isOutOfMemory()
+{
+    if (_memory_limit_mb > 0 && getResidentMemoryMb() > _memory_limit_mb)
+        _out_of_memory = true;
+    return _out_of_memory;
+}
+
+long BudgetManager::getResidentMemoryMb()
+{
+    long num_pages = 0;
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == nullptr)
+        return 0;
+    // Second field: resident set size, in pages
+    if (fscanf(file, "%*s %ld", &num_pages) != 1)
+        num_pages = 0;
+    fclose(file);
+    return num_pages * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
@@ -0,0 +1,73 @@
+#ifndef BUDGET_MANAGER_H
+#define BUDGET_MANAGER_H
+
+#include <atomic>
+#include <string>
+
+#include "util/params.h"
+
+/**
+ * Time and memory budgets of the planner:
+ * -T: wall-clock limit of the whole run (seconds since the program start, 0: none),
+ * -solveT: limit of a single solve call at the first layer (seconds, 0: none), multiplied by
+ *  -solveTGrowth at each new layer,
+ * -mem: limit of the resident memory (MB, 0: none),
+ * -maxDepth: maximum number of layers.
+ * The solver polls terminate() through the IPASIR terminate callback, and the planner calls
+ * beginSolve() before each solve call and canContinue() between its phases.
+ */
+class BudgetManager
+{
+private:
+    const double _time_limit;
+    const double _solve_time_limit;
+    const double _solve_time_growth;
+    const long _memory_limit_mb;
+    const int _max_depth;
+    // Limit of each solve call of the current layer (seconds, 0: none)
+    double _layer_solve_time_limit = 0;
+
+    // Read concurrently by the solvers of the portfolio
+    std::atomic<double> _solve_deadline{0};
+    std::atomic<double> _last_memory_check{0};
+    std::atomic<bool> _out_of_memory{false};
+
+    // Written by canContinue, which is also called by the thread encoding a speculative layer
+    enum class StopReason
+    {
+        NONE,
+        MAX_DEPTH,
+        TIME,
+        MEMORY
+    };
+    std::atomic<StopReason> _stop_reason{StopReason::NONE};
+
+public:
+    BudgetManager(Parameters &params);
+
+    // Set the time limit of the next solve calls, which depends on the depth of the layer
+    void beginLayer(int depth);
+    // Start the time limit of a solve call
+    void beginSolve();
+
+    // True if the planner may go on with the given depth. Otherwise, getStopReason() tells why.
+    bool canContinue(int depth);
+    // Empty if canContinue has always returned true
+    std::string getStopReason() const;
+
+    int getMaxDepth() const
+    {
+        return _max_depth;
+    }
+
+    // IPASIR terminate callback (state: the BudgetManager)
+    static int terminate(void *state);
+
+private:
+    bool isOutOfTime() const;
+    bool isOutOfMemory();
+    // Resident memory of the process, in MB
+    static long getResidentMemoryMb();
+};
+
+#endif // BUDGET_MANAGER_H
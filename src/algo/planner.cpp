@@ -1,12 +1,383 @@
 #include "algo/planner.h"
 #include "util/names.h"
+#include "util/project_utils.h"
+
+bool Planner::expandAndEncodeLayer(const std::vector<PdtNode *> &leaf_nodes, std::vector<PdtNode *> &new_leaf_nodes, int depth)
+{
+    Log::i("  Expanding layer...\n");
+
+    // Expand all the leaf nodes
+    _stats.beginTiming(TimingStage::EXPANSION);
+    int pos = 0;
+    for (PdtNode *node : leaf_nodes)
+    {
+        if (_partial_order_problem)
+        {
+            Log::d("Expand node %s\n", TOSTR(*node));
+            node->expandPOWithBefore(_htn);
+        }
+        else
+        {
+            node->expand(_htn);
+        }
+
+        for (PdtNode *child : node->getChildren())
+        {
+            child->setPos(pos);
+            pos++;
+            new_leaf_nodes.push_back(child);
+        }
+    }
+
+    if (_partial_order_problem)
+    {
+        Log::i("  Adding ordering constraints between no sibling nodes...\n");
+        for (PdtNode *node : new_leaf_nodes)
+        {
+            node->makeOrderingNoSibling();
+        }
+    }
+
+    _stats.endTiming(TimingStage::EXPANSION);
+
+    if (!_budget.canContinue(depth))
+    {
+        Log::w("  Stopping after the expansion of layer %d: %s\n", depth, _budget.getStopReason().c_str());
+        return false;
+    }
+
+    Log::i("  Assigning SAT variables...\n");
+    // Assign the SAT variables for the new layer
+    // (the before variables between the new leaf nodes are created by the encoding, only when needed)
+    int num_aliased_fact_vars = 0;
+    for (PdtNode *node : new_leaf_nodes)
+    {
+        node->assignSatVariables(_htn, _print_var_names, _partial_order_problem, _fact_aliasing, _sibylsat_expansion);
+        num_aliased_fact_vars += node->getNumAliasedFactVariables();
+    }
+    if (_fact_aliasing)
+    {
+        Log::i("  %d/%zu fact variables tied to the ones of the previous node\n", num_aliased_fact_vars, new_leaf_nodes.size() * _htn.getNumPredicates());
+    }
+
+    Log::i("  Encoding...\n");
+    // Encode the new leaf nodes
+    _stats.beginTiming(TimingStage::ENCODING);
+    if (_partial_order_problem)
+    {
+        _enc.encodePOWithBefore(new_leaf_nodes);
+    }
+    else
+    {
+        _enc.encode(new_leaf_nodes);
+    }
+    _stats.endTiming(TimingStage::ENCODING);
+    return true;
+}
+
+void Planner::waitForSpeculation()
+{
+    if (_speculation.joinable())
+        _speculation.join();
+}
+
+int Planner::solveWithoutFailedPrimVars(std::vector<int> prim_vars, const std::vector<int> &leaf_overleaf_vars, const std::vector<int> &previous_next_nodes)
+{
+    size_t num_leaves = prim_vars.size();
+    while (true)
+    {
+        // Only the leaves whose prim assumption is in the failed core of the last solve are relaxed
+        std::vector<int> frozen_prim_vars;
+        for (int prim_var : prim_vars)
+        {
+            if (!_enc.causeFail(prim_var))
+                frozen_prim_vars.push_back(prim_var);
+        }
+        if (frozen_prim_vars.size() == prim_vars.size() || frozen_prim_vars.empty())
+        {
+            // Either the core does not involve the leaves, or no leaf remains primitive: relax as usual
+            return 20;
+        }
+        prim_vars = std::move(frozen_prim_vars);
+
+        Log::i("Solving assuming %d/%d leaf nodes primitive, %d leaf overleaf vars and %d previous next nodes...\n", prim_vars.size(), num_leaves, leaf_overleaf_vars.size(), previous_next_nodes.size());
+        _enc.addAssumptions(prim_vars);
+        _enc.addAssumptions(leaf_overleaf_vars);
+        _enc.addAssumptions(previous_next_nodes);
+        int result = solve();
+        if (result == 0)
+        {
+            return 0;
+        }
+        if (result == 10)
+        {
+            Log::i("  Relaxed solution with %d/%d leaf nodes primitive\n", prim_vars.size(), num_leaves);
+            return 10;
+        }
+    }
+}
+
+bool Planner::solveWithLongestLeafOverleafPrefix()
+{
+    // Assuming fewer leaf overleaf vars can only relax the formula, so the satisfiable prefixes are the
+    // ones shorter than some length
+    auto solveWithPrefix = [&](size_t length)
+    {
+        Log::i("  Try to find a relaxed solution with %d leaf overleafs...\n", (int)length);
+        std::vector<int> leaf_overleaf_vars;
+        for (size_t i = 0; i < length; i++)
+        {
+            leaf_overleaf_vars.push_back(-_leafs_overleafs_vars_to_encode[i]);
+        }
+        _enc.addAssumptions(leaf_overleaf_vars);
+        int result = solve();
+        Log::i("    Result: %d\n", result);
+        return result;
+    };
+    // After an UNSAT solve, all the prefixes containing the failed leaf overleaf vars are UNSAT too
+    auto shortestFailedPrefix = [&](size_t length)
+    {
+        size_t failed_length = 0;
+        for (size_t i = 0; i < length; i++)
+        {
+            if (_enc.causeFail(-_leafs_overleafs_vars_to_encode[i]))
+                failed_length = i + 1;
+        }
+        return failed_length;
+    };
+
+    // The last solve assumed the whole prefix
+    size_t low = 0;
+    size_t high = shortestFailedPrefix(_leafs_overleafs_vars_to_encode.size());
+    int best_length = -1;
+    int last_length = -1;
+    while (low < high)
+    {
+        size_t length = (low + high) / 2;
+        last_length = length;
+        int result = solveWithPrefix(length);
+        if (result == 0)
+        {
+            // Interrupted by the budget: no core to narrow the search, keep the current prefix
+            return false;
+        }
+        if (result == 10)
+        {
+            best_length = length;
+            low = length + 1;
+        }
+        else
+        {
+            high = std::min(length, shortestFailedPrefix(length));
+        }
+    }
+
+    if (best_length == -1)
+    {
+        _leafs_overleafs_vars_to_encode.clear();
+        return false;
+    }
+    _leafs_overleafs_vars_to_encode.resize(best_length);
+    // The model must be the one of the longest satisfiable prefix
+    if (last_length != best_length)
+    {
+        return solveWithPrefix(best_length) == 10;
+    }
+    return true;
+}
+
+void Planner::saveRelaxedValues(const std::vector<PdtNode *> &leaf_nodes)
+{
+    _relaxed_values.clear();
+    auto save = [&](int var)
+    {
+        _relaxed_values[var] = _enc.holds(var);
+    };
+    for (PdtNode *node : leaf_nodes)
+    {
+        for (const auto &[method_idx, var] : node->getMethodAndVariables())
+            save(var);
+        for (const auto &[action_idx, var] : node->getActionAndVariables())
+            save(var);
+        for (int var : node->getFactVariables())
+            save(var);
+        for (const auto &[next_node, var] : node->getPossibleNextNodeVariable())
+            save(var);
+    }
+}
+
+void Planner::seedPhasesFromParents(const std::vector<PdtNode *> &leaf_nodes)
+{
+    auto parentValue = [&](int parent_var)
+    {
+        auto it = _relaxed_values.find(parent_var);
+        return it != _relaxed_values.end() && it->second;
+    };
+
+    int num_seeded = 0;
+    for (PdtNode *node : leaf_nodes)
+    {
+        const PdtNode *parent = node->getParent();
+        if (parent == nullptr)
+            continue;
+
+        // An op is likely true if one of its parent ops is
+        for (const auto &[method_idx, parent_methods] : node->getParentsOfMethod())
+        {
+            bool phase = false;
+            for (int parent_method : parent_methods)
+                phase = phase || parentValue(parent->getMethodAndVariables().at(parent_method));
+            _enc.setPhase(node->getMethodAndVariables().at(method_idx), phase);
+            num_seeded++;
+        }
+        for (const auto &[action_idx, parent_ops] : node->getParentsOfAction())
+        {
+            bool phase = false;
+            for (const auto &[parent_idx, parent_type] : parent_ops)
+            {
+                const FlatMap<int, int> &parent_vars = parent_type == OpType::ACTION ? parent->getActionAndVariables() : parent->getMethodAndVariables();
+                phase = phase || parentValue(parent_vars.at(parent_idx));
+            }
+            _enc.setPhase(node->getActionAndVariables().at(action_idx), phase);
+            num_seeded++;
+        }
+        _enc.setPhase(node->getPrimVariable(), true);
+        num_seeded++;
+
+        // The state around the children of a node is close to the one of the node
+        const std::vector<int> &fact_vars = node->getFactVariables();
+        const std::vector<int> &parent_fact_vars = parent->getFactVariables();
+        for (size_t pred_idx = 0; pred_idx < fact_vars.size() && pred_idx < parent_fact_vars.size(); pred_idx++)
+        {
+            _enc.setPhase(fact_vars[pred_idx], parentValue(parent_fact_vars[pred_idx]));
+            num_seeded++;
+        }
+
+        // Between children of different nodes, follow the order of their parents
+        const PdtNodeMap<int> &parent_next_vars = parent->getPossibleNextNodeVariable();
+        for (const auto &[next_node, var] : node->getPossibleNextNodeVariable())
+        {
+            const PdtNode *next_parent = next_node->getParent();
+            if (next_parent == parent || next_parent == nullptr)
+                continue;
+            auto it = parent_next_vars.find(const_cast<PdtNode *>(next_parent));
+            _enc.setPhase(var, it != parent_next_vars.end() && parentValue(it->second));
+            num_seeded++;
+        }
+    }
+    Log::i("  Seeded the phase of %d variables from the relaxed solution of the previous layer\n", num_seeded);
+    _relaxed_values.clear();
+}
+
+bool Planner::outputPlan(const std::vector<PdtNode *> &leaf_nodes, int depth)
+{
+    // For each node in the PDT, indicate which action or method is true
+    _enc.setOpsTrueInTree(/*node=*/_root_node, /*is_po=*/_partial_order_problem);
+
+    // Generate the plan
+    if (!_plan_manager.generatePlan(_root_node))
+    {
+        Log::e("Error: Failed to generate the final plan.\n");
+        return false;
+    }
+    if (_verify_plan)
+    {
+        // Verify the plan
+        if (!_plan_manager.verifyPlan())
+        {
+            Log::e("Error: Plan verification failed.\n");
+            return false;
+        }
+        Log::i("Plan verified successfully.\n");
+    }
+    // Output the plan
+    Log::log_notime(Log::V0_ESSENTIAL, _plan_manager.getPlanString().c_str());
+    Log::i("End of solution plan. (counted length of %i)\n", _plan_manager.getPlanSize());
+    Log::i("Size of the leaf nodes: %i\n", leaf_nodes.size());
+    Log::i("Number of layers: %i\n", depth);
+
+    if (_write_plan)
+    {
+        std::string plan_path = getRunOutputPath(_htn.getParams().getParam("wpFile"), "plan.txt");
+        if (!_plan_manager.outputPlan(plan_path))
+        {
+            Log::e("Error: Failed to write the plan to file.\n");
+            return false;
+        }
+        Log::i("Plan written to %s\n", plan_path.c_str());
+    }
+    return true;
+}
+
+void Planner::searchShorterPlans(const std::vector<PdtNode *> &leaf_nodes, int depth)
+{
+    // Assumptions of the solve call which found the plan
+    std::vector<int> assumptions = _enc.getLastAssumptions();
+
+    int plan_length = _enc.countPlanActions(leaf_nodes);
+    Log::i("Searching plans shorter than %d actions at layer %d...\n", plan_length, depth);
+    std::vector<int> at_least_vars = _enc.encodePlanLengthCounter(leaf_nodes, plan_length);
+
+    while (plan_length > 0 && _budget.canContinue(depth))
+    {
+        // At most plan_length - 1 actions
+        std::vector<int> bounded_assumptions = assumptions;
+        bounded_assumptions.push_back(-at_least_vars[plan_length - 1]);
+        _enc.addAssumptions(bounded_assumptions);
+        _budget.beginLayer(depth);
+        int result = solve();
+        if (result != 10)
+        {
+            if (result == 20)
+                Log::i("No plan shorter than %d actions at layer %d\n", plan_length, depth);
+            else
+                Log::i("Search of a plan shorter than %d actions interrupted\n", plan_length);
+            return;
+        }
+
+        plan_length = _enc.countPlanActions(leaf_nodes);
+        Log::i("Found a plan with %d actions\n", plan_length);
+        // The time steps of the previous plan must be computed again
+        for (PdtNode *node : leaf_nodes)
+        {
+            node->setTsSolution(-1);
+        }
+        if (!outputPlan(leaf_nodes, depth))
+        {
+            return;
+        }
+    }
+    if (!_budget.getStopReason().empty())
+    {
+        Log::i("Stopped the search of shorter plans: %s\n", _budget.getStopReason().c_str());
+    }
+}
+
+int Planner::solve()
+{
+    _budget.beginSolve();
+    int result = _enc.solve();
+    while (result == 10 && _lazy_transitivity)
+    {
+        // The speculative layer must be fully encoded before adding clauses to the solver
+        waitForSpeculation();
+        int num_added = _enc.addViolatedTransitivityClauses();
+        if (num_added == 0)
+            break;
+        Log::i("    Added %d violated transitivity clauses, solving again...\n", num_added);
+        _enc.repeatLastAssumptions();
+        _budget.beginSolve();
+        result = _enc.solve();
+    }
+    return result;
+}
 
 int Planner::findPlan()
 {
     std::vector<PdtNode *> leaf_nodes;
 
     // Initialize Tree
-    _root_node = new PdtNode(/*parent=*/nullptr);
+    _root_node = _nodes.create(/*parent=*/nullptr);
     int root_method_idx = _htn.getRootTask().getDecompositionMethodsIdx()[0];
     _root_node->addMethodIdx(root_method_idx);
 
@@ -23,103 +394,26 @@ int Planner::findPlan()
 
     // Run main loop
     bool solved = false;
-    int max_depth = 50;
     int current_depth = 0;
     std::vector<PdtNode *> new_leaf_nodes;
-    while (!solved && current_depth < max_depth)
+    while (!solved && _budget.canContinue(current_depth + 1))
     {
         current_depth++;
         Log::i("For depth %d\n", current_depth);
 
-        Log::i("  Expanding layer...\n");
-
-        // Expand all the leaf nodes
-        _stats.beginTiming(TimingStage::EXPANSION);
-        int pos = 0;
-        for (PdtNode *node : leaf_nodes)
-        {
-            if (_partial_order_problem)
-            {
-                Log::d("Expand node %s\n", TOSTR(*node));
-                node->expandPOWithBefore(_htn);
-            }
-            else
-            {
-                node->expand(_htn);
-            }
-
-            for (PdtNode *child : node->getChildren())
-            {
-                child->setPos(pos);
-                pos++;
-                new_leaf_nodes.push_back(child);
-            }
-        }
-
-        if (_partial_order_problem)
-        {
-            Log::i("  Adding ordering constraints between no sibling nodes...\n");
-            for (PdtNode *node : new_leaf_nodes)
-            {
-                node->makeOrderingNoSibling();
-            }
-        }
-
-        _stats.endTiming(TimingStage::EXPANSION);
-
-        Log::i("  Assigning SAT variables...\n");
-        // Assign the SAT variables for the new layer
-        for (int idx_node = 0; idx_node < new_leaf_nodes.size(); ++idx_node)
+        if (!new_leaf_nodes.empty())
         {
-            PdtNode *node = new_leaf_nodes[idx_node];
-            node->assignSatVariables(_htn, _print_var_names, _partial_order_problem);
-            if (_partial_order_problem)
-            {
-                for (int idx_node_2 = idx_node + 1; idx_node_2 < new_leaf_nodes.size(); ++idx_node_2)
-                {
-                    PdtNode *node_2 = new_leaf_nodes[idx_node_2];
-                    // Create a variable to indicate that idx_node is before_idx_node_2
-                    int var = VariableProvider::nextVar();
-                    if (_print_var_names)
-                    {
-                        std::string var_name = "layer_" + std::to_string(current_depth) + "__node_" + node->getName() + "__before__node_" + node_2->getName();
-                        Log::i("PVN: %d %s\n", var, var_name.c_str());
-                    }
-                    // Add the variable to the node
-                    bool can_node_before_node_2 = true;
-                    bool can_node_2_before_node = true;
-                    if (node->getNodeThatMustBeExecutedAfter().find(node_2) != node->getNodeThatMustBeExecutedAfter().end())
-                    {
-                        can_node_2_before_node = false;
-                    }
-                    if (node_2->getNodeThatMustBeExecutedAfter().find(node) != node_2->getNodeThatMustBeExecutedAfter().end())
-                    {
-                        can_node_before_node_2 = false;
-                    }
-                    if (can_node_before_node_2)
-                    {
-                        node->addBeforeNextNodeVar(node_2, var);
-                    }
-                    if (can_node_2_before_node)
-                    {
-                        node_2->addBeforeNextNodeVar(node, -var);
-                    }
-                }
-            }
+            Log::i("  Layer already expanded and encoded during the previous solve\n");
         }
-
-        Log::i("  Encoding...\n");
-        // Encode the new leaf nodes
-        _stats.beginTiming(TimingStage::ENCODING);
-        if (_partial_order_problem)
+        else if (!expandAndEncodeLayer(leaf_nodes, new_leaf_nodes, current_depth))
         {
-            _enc.encodePOWithBefore(new_leaf_nodes);
+            break;
         }
-        else
+        if (_phase_saving && !_relaxed_values.empty())
         {
-            _enc.encode(new_leaf_nodes);
+            seedPhasesFromParents(new_leaf_nodes);
         }
-        _stats.endTiming(TimingStage::ENCODING);
+        _enc.restrictFactDecisions(new_leaf_nodes, _partial_order_problem);
 
         // Add assumptions that each leaf node must be primitive
         std::vector<int> prim_vars;
@@ -154,52 +448,69 @@ int Planner::findPlan()
         _enc.addAssumptions(previous_next_nodes); // Some order between operation on some positions must be enforced
 
         Log::i("  Solving with %d clauses, %d prim vars, %d leaf overleaf vars, %d previous next nodes...\n", _stats._num_cls, prim_vars.size(), leaf_overleaf_vars.size(), previous_next_nodes.size());
+
+        // In pipelined mode, expand and encode the next layer while the solver works on this one
+        std::vector<PdtNode *> next_leaf_nodes;
+        bool speculating = _pipelined && current_depth < _budget.getMaxDepth();
+        bool speculation_complete = true;
+        if (speculating)
+        {
+            _speculation = std::thread([&]()
+                                       {
+                _enc.beginSpeculativeLayer();
+                speculation_complete = expandAndEncodeLayer(new_leaf_nodes, next_leaf_nodes, current_depth + 1);
+                _enc.endSpeculativeLayer(); });
+        }
+
         // Launch the SAT solver
-        int result = _enc.solve();
+        _enc.traceComment("layer " + std::to_string(current_depth));
+        _budget.beginLayer(current_depth);
+        int result = solve();
         // _enc.writeFormula("formula_" + std::to_string(current_depth) + ".cnf");
         Log::i("    Result: %d\n", result);
         solved = (result == 10);
+        if (result == 0)
+        {
+            Log::w("  Solve interrupted at layer %d\n", current_depth);
+        }
 
-        if (!solved && _sibylsat_expansion)
+        if (!solved && result != 0 && _sibylsat_expansion)
         {
             Log::i("  UNSAT... Try to find a relaxed solution...\n");
-            Log::i("Solving assuming %d leaf overleaf vars and %d previous next nodes...\n", leaf_overleaf_vars.size(), previous_next_nodes.size());
-            _enc.addAssumptions(leaf_overleaf_vars);
-            _enc.addAssumptions(previous_next_nodes);
-            int result = _enc.solve();
-
+            if (_core_relaxation)
+            {
+                result = solveWithoutFailedPrimVars(prim_vars, leaf_overleaf_vars, previous_next_nodes);
+            }
             bool relaxed_solved = (result == 10);
+            // Each relaxed solve is only tried if the previous one was not interrupted
+            if (!relaxed_solved && result != 0)
+            {
+                Log::i("Solving assuming %d leaf overleaf vars and %d previous next nodes...\n", leaf_overleaf_vars.size(), previous_next_nodes.size());
+                _enc.addAssumptions(leaf_overleaf_vars);
+                _enc.addAssumptions(previous_next_nodes);
+                result = solve();
+                relaxed_solved = (result == 10);
+            }
 
-            if (!relaxed_solved && previous_next_nodes.size() > 0)
+            if (!relaxed_solved && result != 0 && previous_next_nodes.size() > 0)
             {
                 Log::i("  UNSAT... Now try to relax previous next nodes...\n");
                 Log::i("Solving assuming %d leaf overleaf vars without previous next nodes...\n", leaf_overleaf_vars.size());
                 _previous_nexts_nodes.clear();
                 _enc.addAssumptions(leaf_overleaf_vars);
-                result = _enc.solve();
+                result = solve();
                 relaxed_solved = (result == 10);
             }
 
-            if (!relaxed_solved)
+            if (!relaxed_solved && result != 0)
             {
                 Log::e("UNSAT... No relaxed solution possible for this problem assuming leaf overleaf vars !\n");
-                // _leafs_overleafs_vars_to_encode.clear();
-                while (_leafs_overleafs_vars_to_encode.size() > 0 && !relaxed_solved)
-                {
-                    _leafs_overleafs_vars_to_encode.pop_back();
-                    Log::i("  Try to find a relaxed solution with %d leaf overleafs...\n", _leafs_overleafs_vars_to_encode.size());
-                    std::vector<int> leaf_overleaf_vars;
-                    for (int previous_leaf_overleaf_var : _leafs_overleafs_vars_to_encode)
-                    {
-                        leaf_overleaf_vars.push_back(-previous_leaf_overleaf_var);
-                    }
-                    _enc.addAssumptions(leaf_overleaf_vars);
-                    result = _enc.solve();
-                    Log::i("    Result: %d\n", result);
-                    relaxed_solved = (result == 10);
-                }
+                // Without its leaf overleaf, the facts of the layer are not determined by the ops anymore
+                _enc.setDecisionsRestricted(false);
+                relaxed_solved = solveWithLongestLeafOverleafPrefix();
+                _enc.setDecisionsRestricted(true);
             }
-            else
+            else if (relaxed_solved)
             {
                 Log::i("Found a relaxed solution !\n");
                 // For all leafs nodes, add the next var into the list of previous next nodes
@@ -215,52 +526,77 @@ int Planner::findPlan()
                     }
                 }
             }
+
+            if (relaxed_solved)
+            {
+                _best_relaxed_depth = current_depth;
+                _best_relaxed_num_prim_leaves = 0;
+                for (PdtNode *node : new_leaf_nodes)
+                {
+                    if (_enc.holds(node->getPrimVariable()))
+                        _best_relaxed_num_prim_leaves++;
+                }
+                _best_relaxed_num_leaves = new_leaf_nodes.size();
+                if (_phase_saving)
+                {
+                    saveRelaxedValues(new_leaf_nodes);
+                }
+            }
+        }
+
+        if (speculating)
+        {
+            waitForSpeculation();
+            if (solved)
+            {
+                // The next layer is not needed: remove it from the tree and forget its clauses
+                for (PdtNode *node : new_leaf_nodes)
+                    node->forgetDeeperNodes();
+                for (PdtNode *node : new_leaf_nodes)
+                    node->discardChildren();
+                _nodes.releaseLayer(current_depth + 1);
+                next_leaf_nodes.clear();
+                _enc.discardSpeculativeLayer();
+            }
+            else
+            {
+                _enc.commitSpeculativeLayer();
+            }
+        }
+        // A speculation stopped by the budget only prevents a deeper search: a solved layer keeps its plan
+        if (!speculation_complete && !solved)
+        {
+            break;
         }
 
         leaf_nodes = new_leaf_nodes;
-        new_leaf_nodes.clear();
+        new_leaf_nodes = next_leaf_nodes;
     }
     // If solved, extract the plan and verify it
     if (!solved)
     {
+        if (!_budget.getStopReason().empty())
+        {
+            Log::w("Stopped at layer %d: %s\n", current_depth, _budget.getStopReason().c_str());
+        }
+        if (_best_relaxed_depth > 0)
+        {
+            Log::w("Best relaxed solution at layer %d: %d/%d leaf nodes primitive\n", _best_relaxed_depth, _best_relaxed_num_prim_leaves, _best_relaxed_num_leaves);
+        }
         Log::w("No success. Exiting.\n");
         return 1;
     }
 
     Log::i("Found a solution at layer %i.\n", current_depth);
 
-    // For each node in the PDT, indicate which action or method is true
-    _enc.setOpsTrueInTree(/*node=*/_root_node, /*is_po=*/_partial_order_problem);
-
-    // Generate the plan
-    if (!_plan_manager.generatePlan(_root_node))
+    if (!outputPlan(leaf_nodes, current_depth))
     {
-        Log::e("Error: Failed to generate the final plan.\n");
         return 1;
     }
-    if (_verify_plan)
-    {
-        // Verify the plan
-        if (!_plan_manager.verifyPlan())
-        {
-            Log::e("Error: Plan verification failed.\n");
-            return 1;
-        }
-        Log::i("Plan verified successfully.\n");
-    }
-    // Output the plan
-    Log::log_notime(Log::V0_ESSENTIAL, _plan_manager.getPlanString().c_str());
-    Log::i("End of solution plan. (counted length of %i)\n", _plan_manager.getPlanSize());
-    Log::i("Size of the leaf nodes: %i\n", leaf_nodes.size());
-    Log::i("Number of layers: %i\n", current_depth);
 
-    if (_write_plan)
+    if (_anytime)
     {
-        if (!_plan_manager.outputPlan("plan.txt"))
-        {
-            Log::e("Error: Failed to write the plan to file.\n");
-            return 1;
-        }
+        searchShorterPlans(leaf_nodes, current_depth);
     }
 
     return 0;
@@ -1,10 +1,14 @@
 #ifndef PLANNER_H
 #define PLANNER_H
 
+#include <thread>
+
 #include "data/htn_instance.h"
 #include "sat/encoding.h"
 #include "data/pdt_node.h"
+#include "data/pdt_node_arena.h"
 #include "algo/plan_manager.h"
+#include "algo/budget_manager.h"
 
 
 class Planner
@@ -13,9 +17,11 @@ class Planner
 private:
     HtnInstance &_htn;
     Encoding _enc;
+    PdtNodeArena _nodes;
     PdtNode* _root_node;
     PlanManager _plan_manager;
     Statistics& _stats;
+    BudgetManager _budget;
 
     const bool _write_plan;
     const bool _print_var_names;
@@ -23,24 +29,79 @@ private:
 
     const bool _partial_order_problem;
     const bool _sibylsat_expansion;
+    const bool _pipelined;
+    const bool _lazy_transitivity;
+    const bool _fact_aliasing;
+    const bool _core_relaxation;
+    const bool _anytime;
+    const bool _phase_saving;
+
+    // Thread expanding and encoding the next layer in pipelined mode
+    std::thread _speculation;
 
     std::vector<int> _leafs_overleafs_vars_to_encode;
     std::vector<int> _previous_nexts_nodes;
 
+    // Last relaxed solution, reported if the budget stops the search
+    int _best_relaxed_depth = 0;
+    int _best_relaxed_num_prim_leaves = 0;
+    int _best_relaxed_num_leaves = 0;
+    // Phase saving: values of the variables of the leaf nodes in the last relaxed solution
+    std::unordered_map<int, bool> _relaxed_values;
+
 public:
     Planner(HtnInstance& htn):
     _stats(Statistics::getInstance()),
     _htn(htn),
     _enc(_htn),
     _plan_manager(_htn),
+    _budget(_htn.getParams()),
     _print_var_names(_htn.getParams().isNonzero("pvn")),
     _verify_plan(_htn.getParams().isNonzero("vp")),
     _partial_order_problem(_htn.isPartialOrderProblem()),
     _sibylsat_expansion(_htn.getParams().isNonzero("sibylsat")),
-    _write_plan(_htn.getParams().isNonzero("wp")) {}
-    ~Planner() { delete _root_node; }
+    _pipelined(_htn.getParams().isNonzero("pipeline")),
+    _lazy_transitivity(_htn.getParams().isNonzero("lazyTransitivity")),
+    _fact_aliasing(_htn.getParams().isNonzero("factAliasing")),
+    _core_relaxation(_htn.getParams().isNonzero("coreRelaxation")),
+    _anytime(_htn.getParams().isNonzero("anytime")),
+    _phase_saving(_htn.getParams().isNonzero("phaseSaving")),
+    _write_plan(_htn.getParams().isNonzero("wp"))
+    {
+        _enc.setTerminateCallback(&_budget, &BudgetManager::terminate);
+    }
+    ~Planner() { waitForSpeculation(); }
 
     int findPlan();
+    // Plan found by the last call to findPlan (empty if none)
+    const std::string &getPlanString() const { return _plan_manager.getPlanString(); }
+
+private:
+    // Expand the leaf nodes into new_leaf_nodes, then assign the SAT variables of the new layer and encode it.
+    // Returns false if the budget is exhausted after the expansion (the layer is then not encoded).
+    bool expandAndEncodeLayer(const std::vector<PdtNode *> &leaf_nodes, std::vector<PdtNode *> &new_leaf_nodes, int depth);
+    void waitForSpeculation();
+    // After an UNSAT solve, search for a relaxed solution in which the leaf nodes whose prim assumption
+    // is not in the failed core are still assumed primitive. The core is read again after each UNSAT
+    // answer. Returns 10 if a relaxed solution was found, 0 if a solve call was interrupted, and 20 if no
+    // leaf could be kept primitive.
+    int solveWithoutFailedPrimVars(std::vector<int> prim_vars, const std::vector<int> &leaf_overleaf_vars, const std::vector<int> &previous_next_nodes);
+    // Find the longest prefix of the leaf overleaf vars of the previous layers which can still be assumed,
+    // by binary search narrowed with the failed assumptions, and keep only this prefix.
+    // The last model is the one of this prefix. Returns false if even the empty prefix is UNSAT.
+    bool solveWithLongestLeafOverleafPrefix();
+    // Save the values of the op, fact and next variables of the leaf nodes in the current (relaxed) model
+    void saveRelaxedValues(const std::vector<PdtNode *> &leaf_nodes);
+    // Set the phase of the variables of the new leaf nodes from the saved values of their parents
+    void seedPhasesFromParents(const std::vector<PdtNode *> &leaf_nodes);
+    // Extract the plan of the current model, verify it if asked, and output it
+    bool outputPlan(const std::vector<PdtNode *> &leaf_nodes, int depth);
+    // Anytime mode: once a plan is found, search plans with strictly fewer actions at the same layer
+    // (bounded with a counter over the leaf nodes) and output each one, until none exists or the budget is exhausted
+    void searchShorterPlans(const std::vector<PdtNode *> &leaf_nodes, int depth);
+    // Solve with the current assumptions. With lazy transitivity, the violated transitivity clauses are
+    // added and the formula is solved again (with the same assumptions) until the model is consistent.
+    int solve();
 };
 
 
@@ -0,0 +1,364 @@
+#include "algo/planner_server.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "algo/planner.h"
+#include "data/htn_instance.h"
+#include "util/log.h"
+#include "util/project_utils.h"
+#include "util/signal_manager.h"
+#include "util/statistics.h"
+
+// Maximum size of the first line of a request
+const size_t MAX_REQUEST_HEADER = 1 << 16;
+// Size of the end of the log of the planner sent back when no plan is found
+const size_t LOG_TAIL_SIZE = 4096;
+// Period at which the server checks whether it must exit (milliseconds)
+const int POLL_TIMEOUT_MS = 1000;
+
+// Socket of the server, removed at exit by the server process only (not by its workers)
+static std::string server_socket_path;
+static pid_t server_pid = 0;
+
+// In a worker: connection which has not received its response yet, and log of the planner
+static int pending_fd = -1;
+static std::string worker_log_path;
+
+static void removeServerSocket()
+{
+    if (getpid() == server_pid && !server_socket_path.empty())
+        unlink(server_socket_path.c_str());
+}
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static std::string readLogTail()
+{
+    std::ifstream file(worker_log_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return "";
+    std::streamoff size = file.tellg();
+    std::streamoff start = std::max((std::streamoff)0, size - (std::streamoff)LOG_TAIL_SIZE);
+    file.seekg(start);
+    std::string tail(size - start, '\0');
+    file.read(tail.data(), tail.size());
+    return tail;
+}
+
+static void sendFailure(int fd, const std::string &reason)
+{
+    std::string body = reason + "\n" + readLogTail();
+    std::string header = "FAIL " + std::to_string(body.size()) + "\n";
+    writeAll(fd, header.c_str(), header.size());
+    writeAll(fd, body.c_str(), body.size());
+}
+
+// The planner exits directly on some errors: the client still gets a response
+static void failPendingRequest()
+{
+    if (pending_fd < 0)
+        return;
+    fflush(stdout);
+    fflush(stderr);
+    sendFailure(pending_fd, "The planner exited without a plan");
+    pending_fd = -1;
+}
+
+PlannerServer::PlannerServer(Parameters &params, const std::vector<std::string> &args) : _domain_filename(params.getDomainFilename()),
+                                                                                         _socket_path(params.getParam("server")),
+                                                                                         _workdir(params.getParam("workdir")),
+                                                                                         _keep_workdir(params.isNonzero("keepWorkdir")),
+                                                                                         _max_workers(params.getIntParam("serverWorkers"))
+{
+    if (_max_workers <= 0)
+        _max_workers = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 1; i < args.size(); i++)
+    {
+        const std::string &arg = args[i];
+        if (arg.empty() || arg[0] != '-' || arg.rfind("-server=", 0) == 0 || arg.rfind("-serverWorkers=", 0) == 0)
+            continue;
+        _base_args.push_back(arg);
+    }
+}
+
+bool PlannerServer::openSocket()
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (_socket_path.size() >= sizeof(address.sun_path))
+    {
+        Log::e("Socket path too long: %s\n", _socket_path.c_str());
+        return false;
+    }
+    strcpy(address.sun_path, _socket_path.c_str());
+
+    _listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (_listen_fd < 0)
+    {
+        Log::e("Could not create a socket: %s\n", strerror(errno));
+        return false;
+    }
+    // Left over by a previous server
+    unlink(_socket_path.c_str());
+    if (bind(_listen_fd, (sockaddr *)&address, sizeof(address)) != 0 || listen(_listen_fd, SOMAXCONN) != 0)
+    {
+        Log::e("Could not listen on %s: %s\n", _socket_path.c_str(), strerror(errno));
+        return false;
+    }
+    server_socket_path = _socket_path;
+    server_pid = getpid();
+    atexit(removeServerSocket);
+    return true;
+}
+
+int PlannerServer::run()
+{
+    if (!_domain_filename.empty() && access(_domain_filename.c_str(), R_OK) != 0)
+    {
+        Log::e("Cannot read the domain file %s\n", _domain_filename.c_str());
+        return 1;
+    }
+    if (!openSocket())
+        return 1;
+    // A client closing its connection early must not kill the worker
+    signal(SIGPIPE, SIG_IGN);
+
+    Log::i("Planner server listening on %s (%i workers)\n", _socket_path.c_str(), _max_workers);
+    while (!SignalManager::isExitSet())
+    {
+        reapWorkers(false);
+        if (_num_workers >= _max_workers)
+        {
+            reapWorkers(true);
+            continue;
+        }
+
+        pollfd listen_poll = {_listen_fd, POLLIN, 0};
+        if (poll(&listen_poll, 1, POLL_TIMEOUT_MS) <= 0)
+            continue;
+        int fd = accept4(_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(_listen_fd);
+            handleRequest(fd);
+            // Not reached
+        }
+        if (pid < 0)
+        {
+            Log::w("Could not start a worker: %s\n", strerror(errno));
+            sendResponse(fd, false, "The server could not start a worker");
+        }
+        else
+        {
+            _num_workers++;
+            Log::d("Worker %i started (%i running)\n", pid, _num_workers);
+        }
+        close(fd);
+    }
+    return 0;
+}
+
+void PlannerServer::reapWorkers(bool block)
+{
+    int status;
+    pid_t pid;
+    while (_num_workers > 0 && (pid = waitpid(-1, &status, block ? 0 : WNOHANG)) > 0)
+    {
+        _num_workers--;
+        Log::d("Worker %i exited with status %i\n", pid, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        block = false;
+    }
+}
+
+void PlannerServer::handleRequest(int fd)
+{
+    pending_fd = fd;
+    initProblemProcessingDir(_workdir, _keep_workdir);
+    atexit(failPendingRequest);
+
+    std::vector<std::string> args;
+    std::string error;
+    if (!readRequest(fd, args, error))
+    {
+        sendResponse(fd, false, error);
+        exit(1);
+    }
+
+    // The logs of the planner go into the scratch directory
+    worker_log_path = (getProblemProcessingDir() / "planner.log").string();
+    int log_fd = open(worker_log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (log_fd >= 0)
+    {
+        fflush(stdout);
+        fflush(stderr);
+        dup2(log_fd, STDOUT_FILENO);
+        dup2(log_fd, STDERR_FILENO);
+        close(log_fd);
+    }
+
+    // Parameters::init modifies the arguments
+    std::vector<char *> argv;
+    for (std::string &arg : args)
+        argv.push_back(arg.data());
+    Parameters params;
+    params.init(argv.size(), argv.data());
+    Log::init(params.getIntParam("v"), /*coloredOutput=*/false);
+
+    Statistics::getInstance().beginTiming(TimingStage::TOTAL);
+    HtnInstance htn(params);
+    Planner planner(htn);
+    int result = planner.findPlan();
+    Statistics::getInstance().endTiming(TimingStage::TOTAL);
+    Statistics::getInstance().printStats();
+    fflush(stdout);
+
+    sendResponse(fd, result == 0, result == 0 ? planner.getPlanString() : "No plan found");
+    // Without cleaning up, as in a normal run
+    exit(result);
+}
+
+bool PlannerServer::readRequest(int fd, std::vector<std::string> &args, std::string &error)
+{
+    std::string data;
+    size_t header_end;
+    char buffer[1 << 14];
+    while ((header_end = data.find('\n')) == std::string::npos)
+    {
+        ssize_t num_read = read(fd, buffer, sizeof(buffer));
+        if (num_read < 0 && errno == EINTR)
+            continue;
+        if (num_read <= 0 || data.size() > MAX_REQUEST_HEADER)
+        {
+            error = "Incomplete request";
+            return false;
+        }
+        data.append(buffer, num_read);
+    }
+
+    std::istringstream header(data.substr(0, header_end));
+    data.erase(0, header_end + 1);
+    std::string kind, domain, problem;
+    header >> kind >> domain >> problem;
+    std::vector<std::string> options;
+    for (std::string option; header >> option;)
+    {
+        if (option[0] != '-')
+        {
+            error = "Invalid option " + option;
+            return false;
+        }
+        options.push_back(option);
+    }
+
+    if (kind == "TEXT")
+    {
+        size_t domain_size = 0, problem_size = 0;
+        try
+        {
+            domain_size = domain == "-" ? 0 : std::stoul(domain);
+            problem_size = std::stoul(problem);
+        }
+        catch (const std::exception &e)
+        {
+            error = "Invalid lengths in the request";
+            return false;
+        }
+        while (data.size() < domain_size + problem_size)
+        {
+            ssize_t num_read = read(fd, buffer, sizeof(buffer));
+            if (num_read < 0 && errno == EINTR)
+                continue;
+            if (num_read <= 0)
+            {
+                error = "Incomplete request";
+                return false;
+            }
+            data.append(buffer, num_read);
+        }
+
+        std::filesystem::path dir = getProblemProcessingDir();
+        domain = "-";
+        if (domain_size > 0)
+        {
+            domain = (dir / "domain.hddl").string();
+            std::ofstream(domain, std::ios::binary).write(data.data(), domain_size);
+        }
+        problem = (dir / "problem.hddl").string();
+        std::ofstream(problem, std::ios::binary).write(data.data() + domain_size, problem_size);
+    }
+    else if (kind != "FILES" || problem.empty())
+    {
+        error = "Invalid request, expected FILES <domain> <problem> or TEXT <domain length> <problem length>";
+        return false;
+    }
+
+    if (domain == "-")
+        domain = _domain_filename;
+    if (domain.empty())
+    {
+        error = "No domain given, and the server has none";
+        return false;
+    }
+    for (const std::string &filename : {domain, problem})
+    {
+        if (access(filename.c_str(), R_OK) != 0)
+        {
+            error = "Cannot read " + filename;
+            return false;
+        }
+    }
+
+    args = {"sibylsat-po", domain, problem};
+    args.insert(args.end(), _base_args.begin(), _base_args.end());
+    args.insert(args.end(), options.begin(), options.end());
+    return true;
+}
+
+void PlannerServer::sendResponse(int fd, bool ok, const std::string &body)
+{
+    if (!ok)
+    {
+        sendFailure(fd, body);
+    }
+    else
+    {
+        std::string header = "OK " + std::to_string(body.size()) + "\n";
+        writeAll(fd, header.c_str(), header.size());
+        writeAll(fd, body.c_str(), body.size());
+    }
+    pending_fd = -1;
+}
@@ -0,0 +1,56 @@
+#ifndef PLANNER_SERVER_H
+#define PLANNER_SERVER_H
+
+#include <string>
+#include <vector>
+
+#include "util/params.h"
+
+/**
+ * Long-running planner (-server=<socket path>): listens on a Unix socket and answers each request
+ * with a plan, so that the start of the process is paid once. Each request is handled by a worker
+ * process forked from the server, which runs the planner in its own scratch directory: the planner
+ * relies on global state (variables, names, statistics) and cannot run twice in the same process.
+ * At most -serverWorkers requests are handled at the same time (0: one per core).
+ *
+ * The options of the server are given to each request, followed by the options of the request.
+ * The domain given on the command line of the server (if any) is used by the requests without one.
+ *
+ * Requests (one per connection, the paths and options cannot contain spaces):
+ *   FILES <domain path or -> <problem path> [-option=value ...]\n
+ *   TEXT <domain length or -> <problem length> [-option=value ...]\n<domain text><problem text>
+ * Response:
+ *   OK <length>\n<plan>      or      FAIL <length>\n<reason and end of the log of the planner>
+ */
+class PlannerServer
+{
+private:
+    // Options given to all the requests
+    std::vector<std::string> _base_args;
+    std::string _domain_filename;
+    std::string _socket_path;
+    std::string _workdir;
+    bool _keep_workdir;
+    int _max_workers;
+
+    int _listen_fd = -1;
+    int _num_workers = 0;
+
+public:
+    // args: the command line of the server (before Parameters::init modifies it)
+    PlannerServer(Parameters &params, const std::vector<std::string> &args);
+
+    // Serve the requests until the process is stopped
+    int run();
+
+private:
+    bool openSocket();
+    // Wait for the workers which have exited (for one at least if block)
+    void reapWorkers(bool block);
+    // In the worker process: read the request on the connection, find a plan and send the response
+    void handleRequest(int fd);
+    bool readRequest(int fd, std::vector<std::string> &args, std::string &error);
+    void sendResponse(int fd, bool ok, const std::string &body);
+};
+
+#endif // PLANNER_SERVER_H
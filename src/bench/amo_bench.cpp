@@ -0,0 +1,162 @@
+// Micro-benchmark of the at-most-one encodings (see sat/amo_encoder.h).
+// Usage: amo_bench [max_size] [num_holes]
+// For each strategy, reports the number of clauses, literals and auxiliary variables of a single
+// constraint over n variables, checks on small sizes that the encoding is a correct AMO, and measures
+// the time to solve the pigeonhole problem PHP(num_holes+1, num_holes) (UNSAT) and PHP(num_holes, num_holes) (SAT).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "sat/amo_encoder.h"
+#include "sat/variable_provider.h"
+
+extern "C"
+{
+#include "sat/ipasir.h"
+}
+
+static std::vector<int> newVars(size_t n)
+{
+    std::vector<int> vars(n);
+    for (size_t i = 0; i < n; i++)
+        vars[i] = VariableProvider::nextVar();
+    return vars;
+}
+
+// Gives the clauses directly to a solver
+class SolverSink : public ClauseSink
+{
+private:
+    void *_solver;
+
+public:
+    SolverSink(void *solver) : _solver(solver) {}
+    void addClause(int lit1, int lit2) override
+    {
+        ipasir_add(_solver, lit1);
+        ipasir_add(_solver, lit2);
+        ipasir_add(_solver, 0);
+    }
+    void appendClause(int lit) override
+    {
+        ipasir_add(_solver, lit);
+    }
+    void endClause() override
+    {
+        ipasir_add(_solver, 0);
+    }
+};
+
+// Only counts the clauses and literals
+class CountingSink : public ClauseSink
+{
+public:
+    size_t num_clauses = 0;
+    size_t num_lits = 0;
+    void addClause(int /*lit1*/, int /*lit2*/) override
+    {
+        num_clauses++;
+        num_lits += 2;
+    }
+    void appendClause(int /*lit*/) override
+    {
+        num_lits++;
+    }
+    void endClause() override
+    {
+        num_clauses++;
+    }
+};
+
+// Any single variable can be true, no pair can
+static bool checkAmo(AmoStrategy strategy, size_t n)
+{
+    std::vector<int> vars = newVars(n);
+    void *solver = ipasir_init();
+    SolverSink sink(solver);
+    AmoEncoder::encode(vars, strategy, 0, sink);
+    bool ok = true;
+    for (size_t i = 0; i < n && ok; i++)
+    {
+        ipasir_assume(solver, vars[i]);
+        ok = ipasir_solve(solver) == 10;
+        for (size_t j = i + 1; j < n && ok; j++)
+        {
+            ipasir_assume(solver, vars[i]);
+            ipasir_assume(solver, vars[j]);
+            ok = ipasir_solve(solver) == 20;
+        }
+    }
+    ipasir_release(solver);
+    return ok;
+}
+
+// Pigeonhole problem: each pigeon is in a hole, each hole has at most one pigeon
+static double solvePigeonhole(AmoStrategy strategy, size_t num_pigeons, size_t num_holes, int &result)
+{
+    std::vector<std::vector<int>> in_hole(num_pigeons);
+    for (size_t p = 0; p < num_pigeons; p++)
+        in_hole[p] = newVars(num_holes);
+
+    auto start = std::chrono::steady_clock::now();
+    void *solver = ipasir_init();
+    SolverSink sink(solver);
+    for (size_t p = 0; p < num_pigeons; p++)
+    {
+        for (int var : in_hole[p])
+            ipasir_add(solver, var);
+        ipasir_add(solver, 0);
+    }
+    for (size_t h = 0; h < num_holes; h++)
+    {
+        std::vector<int> pigeons;
+        for (size_t p = 0; p < num_pigeons; p++)
+            pigeons.push_back(in_hole[p][h]);
+        AmoEncoder::encode(pigeons, strategy, 0, sink);
+    }
+    result = ipasir_solve(solver);
+    ipasir_release(solver);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_size = argc > 1 ? atoi(argv[1]) : 1000;
+    size_t num_holes = argc > 2 ? atoi(argv[2]) : 9;
+
+    std::vector<AmoStrategy> strategies = {AmoStrategy::LEGACY};
+    strategies.insert(strategies.end(), AmoEncoder::getExplicitStrategies().begin(), AmoEncoder::getExplicitStrategies().end());
+
+    printf("%-10s %6s %9s %9s %7s\n", "strategy", "n", "clauses", "literals", "aux");
+    for (AmoStrategy strategy : strategies)
+    {
+        for (size_t n : {5, 10, 20, 50, 99, 100, 200, 500, 1000, 5000})
+        {
+            if (n > max_size)
+                break;
+            std::vector<int> vars = newVars(n);
+            int first_aux = VariableProvider::getMaxVar() + 1;
+            CountingSink sink;
+            AmoEncoder::encode(vars, strategy, 0, sink);
+            printf("%-10s %6zu %9zu %9zu %7d\n", AmoEncoder::toString(strategy), n, sink.num_clauses, sink.num_lits,
+                   VariableProvider::getMaxVar() + 1 - first_aux);
+        }
+    }
+
+    printf("\n%-10s %8s %14s %14s\n", "strategy", "correct", "PHP UNSAT (ms)", "PHP SAT (ms)");
+    for (AmoStrategy strategy : strategies)
+    {
+        bool correct = true;
+        for (size_t n : {2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 25, 40})
+            correct = correct && checkAmo(strategy, n);
+        int unsat_result, sat_result;
+        double unsat_time = solvePigeonhole(strategy, num_holes + 1, num_holes, unsat_result);
+        double sat_time = solvePigeonhole(strategy, num_holes, num_holes, sat_result);
+        if (unsat_result != 20 || sat_result != 10)
+            correct = false;
+        printf("%-10s %8s %14.1f %14.1f\n", AmoEncoder::toString(strategy), correct ? "yes" : "NO", unsat_time, sat_time);
+    }
+    return 0;
+}
@@ -0,0 +1,184 @@
+// Replay an incremental CNF trace (written by the planner with -wf=1, see sat/icnf_writer.h) with the
+// IPASIR solver linked to this binary, e.g. to compare solvers offline on real instances.
+// Usage: icnf_replay <trace.icnf | -> [time limit per solve call in seconds]
+// With "-", the trace is read from the standard input (e.g. zstd -dc f.icnf.zst | icnf_replay -).
+// Reports the result and the time of each solve call, and the total solving time.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "sat/ipasir.h"
+}
+
+// Reads the trace through a large buffer
+class TraceReader
+{
+private:
+    FILE *_file;
+    std::vector<char> _buffer;
+    size_t _pos = 0;
+    size_t _size = 0;
+
+public:
+    TraceReader(FILE *file) : _file(file), _buffer(1 << 20) {}
+
+    // Next character, or EOF
+    int peek()
+    {
+        if (_pos == _size)
+        {
+            _size = fread(_buffer.data(), 1, _buffer.size(), _file);
+            _pos = 0;
+            if (_size == 0)
+                return EOF;
+        }
+        return (unsigned char)_buffer[_pos];
+    }
+
+    int get()
+    {
+        int c = peek();
+        if (c != EOF)
+            _pos++;
+        return c;
+    }
+
+    void skipLine()
+    {
+        int c;
+        while ((c = get()) != EOF && c != '\n')
+            ;
+    }
+
+    void skipSpaces()
+    {
+        int c;
+        while ((c = peek()) == ' ' || c == '\t' || c == '\r' || c == '\n')
+            get();
+    }
+
+    bool readInt(int &value)
+    {
+        skipSpaces();
+        bool negative = false;
+        if (peek() == '-')
+        {
+            negative = true;
+            get();
+        }
+        int c = peek();
+        if (c < '0' || c > '9')
+            return false;
+        value = 0;
+        while ((c = peek()) >= '0' && c <= '9')
+        {
+            value = value * 10 + (c - '0');
+            get();
+        }
+        if (negative)
+            value = -value;
+        return true;
+    }
+};
+
+struct Deadline
+{
+    std::chrono::steady_clock::time_point end;
+};
+
+static int terminate(void *state)
+{
+    return std::chrono::steady_clock::now() > static_cast<Deadline *>(state)->end;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <trace.icnf | -> [time limit per solve call in seconds]\n", argv[0]);
+        return 1;
+    }
+    FILE *file = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    double time_limit = argc > 2 ? atof(argv[2]) : 0;
+
+    void *solver = ipasir_init();
+    printf("Replaying %s with %s\n", argv[1], ipasir_signature());
+    Deadline deadline;
+    if (time_limit > 0)
+        ipasir_set_terminate(solver, &deadline, terminate);
+
+    TraceReader reader(file);
+    size_t num_clauses = 0;
+    size_t num_calls = 0;
+    double total_time = 0;
+    while (true)
+    {
+        reader.skipSpaces();
+        int c = reader.peek();
+        if (c == EOF)
+            break;
+        if (c == 'p' || c == 'c')
+        {
+            if (c == 'c')
+            {
+                // Print the comments (e.g. the layers) to follow the solve calls
+                std::string comment;
+                int ch;
+                while ((ch = reader.get()) != EOF && ch != '\n')
+                    comment += (char)ch;
+                printf("%s\n", comment.c_str());
+            }
+            else
+            {
+                reader.skipLine();
+            }
+            continue;
+        }
+        if (c == 'a')
+        {
+            reader.get();
+            int lit;
+            size_t num_assumptions = 0;
+            while (reader.readInt(lit) && lit != 0)
+            {
+                ipasir_assume(solver, lit);
+                num_assumptions++;
+            }
+            deadline.end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_limit));
+            auto start = std::chrono::steady_clock::now();
+            int result = ipasir_solve(solver);
+            double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            total_time += time;
+            num_calls++;
+            printf("solve %zu: %zu clauses, %zu assumptions -> %s in %.3f s\n", num_calls, num_clauses, num_assumptions,
+                   result == 10 ? "SAT" : (result == 20 ? "UNSAT" : "UNKNOWN"), time);
+            continue;
+        }
+        int lit;
+        if (!reader.readInt(lit))
+        {
+            fprintf(stderr, "Unexpected character '%c' in the trace\n", c);
+            return 1;
+        }
+        ipasir_add(solver, lit);
+        if (lit == 0)
+            num_clauses++;
+    }
+    printf("%zu solve calls, %zu clauses, total solving time %.3f s\n", num_calls, num_clauses, total_time);
+
+    ipasir_release(solver);
+    if (file != stdin)
+        fclose(file);
+    return 0;
+}
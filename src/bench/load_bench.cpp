@@ -0,0 +1,88 @@
+// Benchmark of the loading of a grounded problem (output of pandaPIgrounder, see HtnInstance).
+// Usage: load_bench <grounded problem> [max_threads] [repetitions]
+// Reports the best time to create the HtnInstance from the grounded file with 1, 2, 4... up to max_threads
+// threads (-loadThreads), and, as a reference, the time to only read the same file line by line with
+// std::getline and an std::istringstream per line, as the loader used to do.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "data/htn_instance.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/timer.h"
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double readWithGetline(const std::string &filepath, size_t &num_values)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream file(filepath);
+    std::string line;
+    num_values = 0;
+    while (std::getline(file, line))
+    {
+        std::istringstream iss(line);
+        int value;
+        while (iss >> value)
+            num_values++;
+    }
+    return elapsedMs(start);
+}
+
+static double load(const std::string &filepath, int num_threads, size_t &num_actions, size_t &num_methods)
+{
+    std::string threads_arg = "-loadThreads=" + std::to_string(num_threads);
+    std::vector<std::string> args = {"load_bench", filepath, filepath, "-grounded=1", "-sibylsat=0", threads_arg};
+    std::vector<char *> argv;
+    for (std::string &arg : args)
+        argv.push_back(arg.data());
+    Parameters params;
+    params.init(argv.size(), argv.data());
+
+    auto start = std::chrono::steady_clock::now();
+    HtnInstance htn(params);
+    double time = elapsedMs(start);
+    num_actions = htn.getNumActions();
+    num_methods = htn.getNumMethods();
+    return time;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage: load_bench <grounded problem> [max_threads] [repetitions]\n");
+        return 1;
+    }
+    std::string filepath = argv[1];
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    int repetitions = argc > 3 ? atoi(argv[3]) : 3;
+
+    Timer::init();
+    Log::init(0, false);
+
+    size_t num_values;
+    double getline_time = 1e30;
+    for (int i = 0; i < repetitions; i++)
+        getline_time = std::min(getline_time, readWithGetline(filepath, num_values));
+    printf("%-26s %10.1f ms (%zu integers)\n", "getline + istringstream", getline_time, num_values);
+
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        size_t num_actions = 0, num_methods = 0;
+        double time = 1e30;
+        for (int i = 0; i < repetitions; i++)
+            time = std::min(time, load(filepath, num_threads, num_actions, num_methods));
+        printf("load, %2d thread(s)         %10.1f ms (%zu actions, %zu methods)\n", num_threads, time, num_actions, num_methods);
+    }
+    return 0;
+}
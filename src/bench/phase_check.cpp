@@ -0,0 +1,59 @@
+// Check of the phases given to the IPASIR solver (SatInterface::setPhase, used by -phaseSaving).
+// Usage: phase_check [num_vars]
+// The phase of each variable is set to a value, then the formula is solved: as nothing forces the
+// variables away from their phase, each one must be decided to the value it was given.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "sat/sat_interface.h"
+#include "sat/variable_provider.h"
+#include "util/params.h"
+
+// Number of variables which do not take the value of their phase
+static int countMismatches(SatInterface &sat, int num_vars, bool invert)
+{
+    std::vector<int> vars(num_vars);
+    std::vector<bool> phases(num_vars);
+    for (int i = 0; i < num_vars; i++)
+    {
+        vars[i] = VariableProvider::nextVar();
+        phases[i] = (i % 3 == 0) != invert;
+        sat.setPhase(vars[i], phases[i]);
+    }
+    // Satisfied by the phases, whatever the order of the decisions
+    for (int i = 0; i < num_vars; i++)
+        sat.appendClause(phases[i] ? vars[i] : -vars[i]);
+    sat.endClause();
+
+    if (sat.solve() != 10)
+    {
+        printf("Unexpected result of the solver\n");
+        return num_vars;
+    }
+    int num_mismatches = 0;
+    for (int i = 0; i < num_vars; i++)
+    {
+        if (sat.holds(vars[i]) != phases[i])
+            num_mismatches++;
+    }
+    return num_mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    int num_vars = argc > 1 ? atoi(argv[1]) : 100;
+
+    char name[] = "phase_check";
+    char *params_argv[] = {name};
+    Parameters params;
+    params.init(1, params_argv);
+    SatInterface sat(params);
+
+    int num_mismatches = 0;
+    for (bool invert : {false, true})
+        num_mismatches += countMismatches(sat, num_vars, invert);
+    printf("%d / %d variables decided to their phase\n", 2 * num_vars - num_mismatches, 2 * num_vars);
+    return num_mismatches == 0 ? 0 : 1;
+}
@@ -16,7 +16,7 @@ private:
     std::vector<int> _neg_effs_idx;
 
 public:
-    Action(int id, std::vector<int> preconditions_idx, std::vector<int> pos_effs_idx, std::vector<int> neg_effs_idx) : _id(id), _preconditions_idx(preconditions_idx), _pos_effs_idx(pos_effs_idx), _neg_effs_idx(neg_effs_idx) {}
+    Action(int id, std::vector<int> preconditions_idx, std::vector<int> pos_effs_idx, std::vector<int> neg_effs_idx) : _id(id), _preconditions_idx(std::move(preconditions_idx)), _pos_effs_idx(std::move(pos_effs_idx)), _neg_effs_idx(std::move(neg_effs_idx)) {}
 
     void addName(std::string name) { _name = name; }
     
@@ -4,6 +4,11 @@
 #include <fstream>
 #include <iostream>
 #include <optional>
+#include <sstream>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <unistd.h>
 #include <queue>
 #include <assert.h>
 #include <unordered_map>
@@ -16,29 +21,76 @@
 
 #include "util/log.h"
 #include "util/command_utils.h"
+#include "util/binary_io.h"
+#include "util/mapped_file.h"
+#include "util/text_scanner.h"
+#include "util/timer.h"
 #include "util/project_utils.h"
 #include "util/names.h"
 #include "sat/variable_provider.h"
 #include "algo/effects_inference.h"
 
+// Number of actions or methods under which a chunk is not worth a task of its own
+const size_t MIN_RECORDS_PER_CHUNK = 1024;
+
+// Header of the snapshots of preprocessed instances. The version must be increased whenever
+// their contents or the preprocessing they store change.
+const uint64_t SNAPSHOT_MAGIC = 0x50414e5359424953ULL; // "SIBYSNAP"
+const int SNAPSHOT_VERSION = 2;
+// Second offset basis of the hashes of the input files, which makes their hash 128-bit long
+const uint64_t SNAPSHOT_SECOND_BASIS = 0x6c62272e07bb0142ULL;
+
 HtnInstance::HtnInstance(Parameters &params) : _params(params), _stats(Statistics::getInstance())
 {
-    Log::i("Parsing the domain and problem files...\n");
-    auto parsed_problem = parseProblem(params.getDomainFilename(), params.getProblemFilename());
-    if (!parsed_problem)
-        return;
+    std::string snapshot_key;
+    std::string snapshot_path;
+    if (params.isNonzero("snapshots"))
+    {
+        snapshot_key = getSnapshotKey();
+        snapshot_path = getSnapshotPath(snapshot_key);
+        if (loadSnapshot(snapshot_path, snapshot_key))
+        {
+            Log::i("Loaded the preprocessed instance from the snapshot %s\n", snapshot_path.c_str());
+            return;
+        }
+    }
 
-    Log::i("Grounding the parsed problem...\n");
-    auto grounded_problem = groundProblem(*parsed_problem);
-    if (!grounded_problem)
-        return;
+    std::optional<std::string> grounded_problem;
+    std::string grounded_text;
+    if (params.isNonzero("grounded"))
+    {
+        grounded_problem = params.getProblemFilename();
+        loadGroundedProblem(*grounded_problem);
+    }
+    else if (params.isNonzero("pipeGrounding") && parseAndGroundThroughPipes(params.getDomainFilename(), params.getProblemFilename(), grounded_text))
+    {
+        loadGroundedProblem(std::string_view(grounded_text));
+    }
+    else
+    {
+        Log::i("Parsing the domain and problem files...\n");
+        auto parsed_problem = parseProblem(params.getDomainFilename(), params.getProblemFilename());
+        if (!parsed_problem)
+            return;
+
+        Log::i("Grounding the parsed problem...\n");
+        grounded_problem = groundProblem(*parsed_problem);
+        if (!grounded_problem)
+            return;
 
-    loadGroundedProblem(*grounded_problem);
+        loadGroundedProblem(*grounded_problem);
+    }
 
     if (_params.isNonzero("sibylsat"))
     {
         if (!_partial_order_problem)
         {
+            // pandaPIengine only reads the grounded problem from a file
+            if (!grounded_problem)
+            {
+                grounded_problem = (getProblemProcessingDir() / "problem.grounded").string();
+                std::ofstream(*grounded_problem) << grounded_text;
+            }
             bool res = getPrecsAndEffsMethods(*grounded_problem);
             exit(0);
         }
@@ -52,6 +104,426 @@ HtnInstance::HtnInstance(Parameters &params) : _params(params), _stats(Statistic
             _stats.endTiming(TimingStage::COMPUTE_PRECS_AND_EFFS);
         }
     }
+
+    if (!snapshot_path.empty())
+    {
+        saveSnapshot(snapshot_path, snapshot_key);
+    }
+}
+
+void HtnInstance::initSpecialActions()
+{
+    // Initialize the blank action
+    _blankAction = new Action(_id_blank_action, {}, {}, {});
+    _blankAction->addName("blank");
+
+    // Initialize the init and goal action (only used in partial order with before)
+    // _id_init_action = _actions.size() + _abstr_tasks.size();
+    // _id_goal_action = _actions.size() + _abstr_tasks.size() + 1;
+    std::vector<int> init_pos_effects;
+    std::vector<int> init_neg_effects;
+    for (int i = 0; i < _predicates.size(); i++)
+    {
+        if (_init_state.find(i) != _init_state.end())
+        {
+            init_pos_effects.push_back(i);
+        }
+        else
+        {
+            init_neg_effects.push_back(i);
+        }
+    }
+    _init_action = new Action(_id_init_action, {}, init_pos_effects, init_neg_effects);
+    _init_action->addName("__init__");
+
+    std::vector<int> goal_pos_precs;
+    for (int i = 0; i < _predicates.size(); i++)
+    {
+        if (_goal_state.find(i) != _goal_state.end())
+        {
+            goal_pos_precs.push_back(i);
+        }
+    }
+    _goal_action = new Action(_id_goal_action, goal_pos_precs, {}, {});
+    _goal_action->addName("__goal__");
+
+    // Initialize all the facts vars for the goal state
+    for (int i = 0; i < _predicates.size(); i++)
+    {
+        _all_fact_vars_goal.push_back(VariableProvider::nextVar());
+    }
+}
+
+std::string HtnInstance::getSnapshotKey() const
+{
+    // Everything the preprocessed instance depends on: the input files and the parameters read until the effects inference
+    std::string key = "v" + std::to_string(SNAPSHOT_VERSION);
+    for (const std::string &filepath : {_params.getDomainFilename(), _params.getProblemFilename()})
+    {
+        MappedFile file;
+        if (!file.open(filepath))
+        {
+            Log::w("Unable to read %s to compute the snapshot key\n", filepath.c_str());
+        }
+        char file_key[64];
+        snprintf(file_key, sizeof(file_key), ";%zu:%016llx%016llx", file.getContents().size(),
+                 (unsigned long long)fnv1a(file.getContents()), (unsigned long long)fnv1a(file.getContents(), SNAPSHOT_SECOND_BASIS));
+        key += file_key;
+    }
+    for (const char *param : {"grounded", "po", "mutex", "nsp", "simplifyPreds", "removeMethodPrecAction", "sibylsat"})
+    {
+        key += std::string(";") + param + "=" + _params.getParam(param);
+    }
+    return key;
+}
+
+std::string HtnInstance::getSnapshotPath(const std::string &key) const
+{
+    std::filesystem::path dir = _params.getParam("snapshotDir");
+    if (dir.is_relative())
+    {
+        dir = getProjectRootDir() / dir;
+    }
+    std::filesystem::create_directories(dir);
+    char filename[32];
+    snprintf(filename, sizeof(filename), "%016llx.snap", (unsigned long long)fnv1a(key));
+    return (dir / filename).string();
+}
+
+// The unordered sets are written with their number of buckets and read back by inserting their values in reverse
+// order into as many buckets, which keeps their iteration order (and so the order of the clauses encoded from them)
+static void writeSet(BinaryWriter &writer, const std::unordered_set<int> &values)
+{
+    writer.writeInt(values.bucket_count());
+    writer.writeInts(values);
+}
+
+static std::unordered_set<int> readSet(BinaryReader &reader)
+{
+    size_t bucket_count = reader.readSize(0);
+    std::vector<int> values = reader.readInts();
+    // The sets are built by insertions only, so that their number of buckets stays close to their size
+    if (bucket_count > 4 * values.size() + 64)
+    {
+        reader.fail();
+        return {};
+    }
+    std::unordered_set<int> set;
+    set.rehash(bucket_count);
+    set.insert(values.rbegin(), values.rend());
+    return set;
+}
+
+void HtnInstance::saveSnapshot(const std::string &snapshot_path, const std::string &key) const
+{
+    BinaryWriter writer;
+    writer.writeU64(SNAPSHOT_MAGIC);
+    writer.writeInt(SNAPSHOT_VERSION);
+    writer.writeString(key);
+
+    writer.writeInt(_predicates.size());
+    for (const Predicate &predicate : _predicates)
+    {
+        writer.writeInt(predicate.isPositive());
+        writer.writeString(predicate.getName());
+    }
+    writer.writeInt(_actions.size());
+    for (const Action &action : _actions)
+    {
+        writer.writeString(action.getName());
+        writer.writeInts(action.getPreconditionsIdx());
+        writer.writeInts(action.getPosEffsIdx());
+        writer.writeInts(action.getNegEffsIdx());
+    }
+    writer.writeInt(_abstr_tasks.size());
+    for (const AbstractTask &task : _abstr_tasks)
+    {
+        writer.writeInt(task.getId());
+        writer.writeString(task.getName());
+        writer.writeInts(task.getDecompositionMethodsIdx());
+    }
+    writer.writeInt(_methods.size());
+    for (const Method &method : _methods)
+    {
+        writer.writeString(method.getName());
+        writer.writeInt(method.getParentTaskIdx());
+        writer.writeInts(method.getSubtasksIdx());
+        writer.writeInt(method.getOrderingConstraints().size());
+        for (const auto &[first, second] : method.getOrderingConstraints())
+        {
+            writer.writeInt(first);
+            writer.writeInt(second);
+        }
+        writeSet(writer, method.getPreconditionsIdx());
+        writeSet(writer, method.getPosEffsIdx());
+        writeSet(writer, method.getNegEffsIdx());
+        writeSet(writer, method.getPossPosEffsIdx());
+        writeSet(writer, method.getPossNegEffsIdx());
+    }
+    writer.writeInt(_mutex.getMutexGroups().size());
+    for (const std::vector<int> &group : _mutex.getMutexGroups())
+    {
+        writer.writeInts(group);
+    }
+
+    writer.writeInt(_root_task_idx);
+    writeSet(writer, _init_state);
+    writeSet(writer, _goal_state);
+    writer.writeInt(_methods_to_precondition_action.size());
+    for (const auto &[method_id, action_id] : _methods_to_precondition_action)
+    {
+        writer.writeInt(method_id);
+        writer.writeInt(action_id);
+    }
+    // The canonical structures are rebuilt from their details
+    writer.writeInt(_structure_id_to_details.size());
+    for (const auto &[structure_id, details] : _structure_id_to_details)
+    {
+        writer.writeInt(structure_id);
+        writer.writeInt(details.first);
+        writer.writeInt(details.second.size());
+        for (const auto &[first, second] : details.second)
+        {
+            writer.writeInt(first);
+            writer.writeInt(second);
+        }
+    }
+    writer.writeInt(_method_to_structure_id.size());
+    for (const auto &[method_id, structure_id] : _method_to_structure_id)
+    {
+        writer.writeInt(method_id);
+        writer.writeInt(structure_id);
+    }
+    // Checksum of all the above, against the corruptions which keep the indices in range
+    writer.writeU64(fnv1a(writer.getData()));
+
+    // Written aside then renamed, so that concurrent runs never read a partial snapshot
+    std::string tmp_path = snapshot_path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(tmp_path, std::ios::binary);
+        file.write(writer.getData().data(), writer.getData().size());
+        if (!file)
+        {
+            Log::w("Unable to write the snapshot %s\n", tmp_path.c_str());
+            std::filesystem::remove(tmp_path);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp_path, snapshot_path);
+    Log::i("Saved the preprocessed instance into the snapshot %s (%zu bytes)\n", snapshot_path.c_str(), writer.getData().size());
+}
+
+bool HtnInstance::loadSnapshot(const std::string &snapshot_path, const std::string &key)
+{
+    MappedFile file;
+    if (!std::filesystem::exists(snapshot_path) || !file.open(snapshot_path))
+    {
+        return false;
+    }
+    std::string_view contents = file.getContents();
+    uint64_t checksum = 0;
+    if (contents.size() >= sizeof(checksum))
+    {
+        memcpy(&checksum, contents.data() + contents.size() - sizeof(checksum), sizeof(checksum));
+        contents.remove_suffix(sizeof(checksum));
+    }
+    if (checksum != fnv1a(contents))
+    {
+        Log::w("Ignoring the truncated or corrupted snapshot %s\n", snapshot_path.c_str());
+        return false;
+    }
+    BinaryReader reader(contents);
+    if (reader.readU64() != SNAPSHOT_MAGIC || reader.readInt() != SNAPSHOT_VERSION)
+    {
+        Log::w("Ignoring the snapshot %s of another version\n", snapshot_path.c_str());
+        return false;
+    }
+    if (reader.readString() != key)
+    {
+        Log::w("Ignoring the snapshot %s of other inputs with the same hash\n", snapshot_path.c_str());
+        return false;
+    }
+
+    auto readPairs = [&reader]()
+    {
+        std::vector<std::pair<int, int>> pairs(reader.readSize(2 * sizeof(int32_t)));
+        for (auto &[first, second] : pairs)
+        {
+            first = reader.readInt();
+            second = reader.readInt();
+        }
+        return pairs;
+    };
+
+    size_t num_predicates = reader.readSize(sizeof(int32_t));
+    _predicates.reserve(num_predicates);
+    for (size_t i = 0; i < num_predicates; i++)
+    {
+        bool is_positive = reader.readInt();
+        _predicates.emplace_back(i, is_positive, reader.readString());
+    }
+    size_t num_actions = reader.readSize(sizeof(int32_t));
+    _actions.reserve(num_actions);
+    for (size_t i = 0; i < num_actions; i++)
+    {
+        std::string name = reader.readString();
+        std::vector<int> preconditions = reader.readInts();
+        std::vector<int> positive_effects = reader.readInts();
+        _actions.emplace_back(i, std::move(preconditions), std::move(positive_effects), reader.readInts());
+        _actions.back().addName(name);
+    }
+    size_t num_abstract_tasks = reader.readSize(sizeof(int32_t));
+    _abstr_tasks.reserve(num_abstract_tasks);
+    for (size_t i = 0; i < num_abstract_tasks; i++)
+    {
+        int task_id = reader.readInt();
+        _abstr_tasks.emplace_back(task_id, reader.readString());
+        for (int method_id : reader.readInts())
+        {
+            _abstr_tasks.back().addDecompositionMethod(method_id);
+        }
+    }
+    size_t num_methods = reader.readSize(sizeof(int32_t));
+    _methods.reserve(num_methods);
+    for (size_t i = 0; i < num_methods; i++)
+    {
+        std::string name = reader.readString();
+        int parent_task_idx = reader.readInt();
+        std::vector<int> subtasks_ids = reader.readInts();
+        _methods.emplace_back(i, std::move(name), parent_task_idx, std::move(subtasks_ids), readPairs());
+        Method &method = _methods.back();
+        method.setPreconditions(readSet(reader));
+        method.setPositiveEffects(readSet(reader));
+        method.setNegativeEffects(readSet(reader));
+        method.setPossiblePositiveEffects(readSet(reader));
+        method.setPossibleNegativeEffects(readSet(reader));
+    }
+    size_t num_mutex_groups = reader.readSize(sizeof(int32_t));
+    for (size_t i = 0; i < num_mutex_groups; i++)
+    {
+        _mutex.addMutexGroup(reader.readInts());
+    }
+
+    _root_task_idx = reader.readInt();
+    _init_state = readSet(reader);
+    _goal_state = readSet(reader);
+    for (const auto &[method_id, action_id] : readPairs())
+    {
+        _methods_to_precondition_action[method_id] = action_id;
+    }
+    size_t num_structures = reader.readSize(3 * sizeof(int32_t));
+    for (size_t i = 0; i < num_structures; i++)
+    {
+        int structure_id = reader.readInt();
+        int num_subtasks = reader.readInt();
+        auto details = std::make_pair(num_subtasks, readPairs());
+        _canonical_structure_to_id[details] = structure_id;
+        _structure_id_to_details[structure_id] = std::move(details);
+        _next_structure_id = std::max(_next_structure_id, structure_id + 1);
+    }
+    for (const auto &[method_id, structure_id] : readPairs())
+    {
+        _method_to_structure_id[method_id] = structure_id;
+    }
+
+    if (!reader.ok() || !reader.atEnd() || !isSnapshotConsistent())
+    {
+        Log::w("Ignoring the truncated or corrupted snapshot %s\n", snapshot_path.c_str());
+        _predicates.clear();
+        _actions.clear();
+        _abstr_tasks.clear();
+        _methods.clear();
+        _mutex = Mutex();
+        _init_state.clear();
+        _goal_state.clear();
+        _methods_to_precondition_action.clear();
+        _canonical_structure_to_id.clear();
+        _structure_id_to_details.clear();
+        _method_to_structure_id.clear();
+        _next_structure_id = 0;
+        return false;
+    }
+
+    initSpecialActions();
+    Names::init(_predicates, _actions, _abstr_tasks, _methods, _blankAction, _init_action, _goal_action);
+    return true;
+}
+
+bool HtnInstance::isSnapshotConsistent() const
+{
+    int num_predicates = _predicates.size();
+    int num_actions = _actions.size();
+    int num_tasks = num_actions + _abstr_tasks.size();
+    int num_methods = _methods.size();
+    auto inRange = [](int value, int begin, int end)
+    {
+        return value >= begin && value < end;
+    };
+    auto arePredicates = [&](const auto &values)
+    {
+        return std::all_of(values.begin(), values.end(), [&](int pred_idx)
+                           { return inRange(pred_idx, 0, num_predicates); });
+    };
+    auto arePositions = [&](const std::vector<std::pair<int, int>> &pairs, int num_positions)
+    {
+        return std::all_of(pairs.begin(), pairs.end(), [&](const std::pair<int, int> &pair)
+                           { return inRange(pair.first, 0, num_positions) && inRange(pair.second, 0, num_positions); });
+    };
+
+    for (const Action &action : _actions)
+    {
+        if (!arePredicates(action.getPreconditionsIdx()) || !arePredicates(action.getPosEffsIdx()) || !arePredicates(action.getNegEffsIdx()))
+            return false;
+    }
+    for (size_t i = 0; i < _abstr_tasks.size(); i++)
+    {
+        if (_abstr_tasks[i].getId() != num_actions + (int)i)
+            return false;
+        for (int method_id : _abstr_tasks[i].getDecompositionMethodsIdx())
+        {
+            if (!inRange(method_id, 0, num_methods))
+                return false;
+        }
+    }
+    for (const Method &method : _methods)
+    {
+        if (!inRange(method.getParentTaskIdx(), num_actions, num_tasks))
+            return false;
+        for (int subtask_id : method.getSubtasksIdx())
+        {
+            // The root method also contains the init and goal actions
+            if (!inRange(subtask_id, 0, num_tasks) && subtask_id != _id_init_action && subtask_id != _id_goal_action)
+                return false;
+        }
+        if (!arePositions(method.getOrderingConstraints(), method.getSubtasksIdx().size()))
+            return false;
+        if (!arePredicates(method.getPreconditionsIdx()) || !arePredicates(method.getPosEffsIdx()) || !arePredicates(method.getNegEffsIdx()) ||
+            !arePredicates(method.getPossPosEffsIdx()) || !arePredicates(method.getPossNegEffsIdx()))
+            return false;
+    }
+    for (const std::vector<int> &group : _mutex.getMutexGroups())
+    {
+        if (!arePredicates(group))
+            return false;
+    }
+    if (!inRange(_root_task_idx, num_actions, num_tasks) || !arePredicates(_init_state) || !arePredicates(_goal_state))
+        return false;
+    for (const auto &[method_id, action_id] : _methods_to_precondition_action)
+    {
+        if (!inRange(method_id, 0, num_methods) || !inRange(action_id, 0, num_actions))
+            return false;
+    }
+    for (const auto &[structure_id, details] : _structure_id_to_details)
+    {
+        if (details.first < 0 || !arePositions(details.second, details.first))
+            return false;
+    }
+    for (const auto &[method_id, structure_id] : _method_to_structure_id)
+    {
+        if (!inRange(method_id, 0, num_methods) || !_structure_id_to_details.count(structure_id))
+            return false;
+    }
+    return true;
 }
 
 std::optional<std::string> HtnInstance::parseProblem(const std::string &domain_filepath, const std::string &problem_filepath)
@@ -96,73 +568,68 @@ std::optional<std::string> HtnInstance::groundProblem(const std::string &parsed_
     return output_filepath;
 }
 
-void HtnInstance::loadGroundedProblem(const std::string &grounded_problem_filepath)
+bool HtnInstance::parseAndGroundThroughPipes(const std::string &domain_filepath, const std::string &problem_filepath, std::string &grounded_problem)
 {
-    if (!std::filesystem::exists(grounded_problem_filepath))
+    Log::i("Parsing and grounding the problem through pipes...\n");
+    std::vector<std::string> parser_command = {(getProjectRootDir() / "lib" / "pandaPIparser").string()};
+    if (_params.isNonzero("nsp"))
     {
-        Log::e("Error: The grounded problem file does not exist.\n");
-        return;
+        parser_command.push_back("--no-split-parameters");
     }
+    parser_command.insert(parser_command.end(), {domain_filepath, problem_filepath, PIPELINE_OUTPUT_PATH});
 
-    std::ifstream file(grounded_problem_filepath);
-    if (!file)
+    std::vector<std::string> grounder_command = {(getProjectRootDir() / "lib" / "pandaPIgrounder").string()};
+    if (_params.isNonzero("mutex"))
     {
-        Log::e("Error: Unable to open the grounded problem file.\n");
-        return;
+        grounder_command.push_back("--invariants");
     }
+    grounder_command.insert(grounder_command.end(), {PIPELINE_INPUT_PATH, PIPELINE_OUTPUT_PATH});
 
-    int line_idx = 0;
-    extractPredicates(file, line_idx);
-    if (_params.isNonzero("mutex"))
+    if (!runPipeline({parser_command, grounder_command}, grounded_problem) || grounded_problem.empty())
     {
-        extractMutexes(file, line_idx);
+        Log::w("Parsing and grounding through pipes failed, falling back to intermediate files.\n");
+        return false;
     }
-    extractActions(file, line_idx);
-    extractInitGoalStates(file, line_idx);
-    extractTasksNames(file, line_idx);
-    extractInitRootTaskIdx(file, line_idx);
-    extractMethods(file, line_idx);
-
-    // Initialize the blank action
-    _blankAction = new Action(_id_blank_action, {}, {}, {});
-    _blankAction->addName("blank");
+    return true;
+}
 
-    // Initialize the init and goal action (only used in partial order with before)
-    // _id_init_action = _actions.size() + _abstr_tasks.size();
-    // _id_goal_action = _actions.size() + _abstr_tasks.size() + 1;
-    std::vector<int> init_pos_effects;
-    std::vector<int> init_neg_effects;
-    for (int i = 0; i < _predicates.size(); i++)
+void HtnInstance::loadGroundedProblem(const std::string &grounded_problem_filepath)
+{
+    MappedFile file;
+    if (!file.open(grounded_problem_filepath))
     {
-        if (_init_state.find(i) != _init_state.end())
-        {
-            init_pos_effects.push_back(i);
-        }
-        else
-        {
-            init_neg_effects.push_back(i);
-        }
+        Log::e("Error: Unable to open the grounded problem file.\n");
+        return;
     }
-    _init_action = new Action(_id_init_action, {}, init_pos_effects, init_neg_effects);
-    _init_action->addName("__init__");
+    loadGroundedProblem(file.getContents());
+}
 
-    std::vector<int> goal_pos_precs;
-    for (int i = 0; i < _predicates.size(); i++)
+void HtnInstance::loadGroundedProblem(std::string_view contents)
+{
+    double start_time = Timer::elapsedSeconds();
+    int num_threads = _params.getIntParam("loadThreads");
+    std::unique_ptr<ThreadPool> pool = num_threads > 1 ? std::make_unique<ThreadPool>(num_threads) : nullptr;
+
+    TextScanner scanner(contents);
+    extractPredicates(scanner);
+    if (_params.isNonzero("mutex"))
     {
-        if (_goal_state.find(i) != _goal_state.end())
-        {
-            goal_pos_precs.push_back(i);
-        }
+        extractMutexes(scanner);
     }
-    _goal_action = new Action(_id_goal_action, goal_pos_precs, {}, {});
-    _goal_action->addName("__goal__");
-
-    // Initialize all the facts vars for the goal state
-    for (int i = 0; i < _predicates.size(); i++)
+    extractActions(scanner, pool.get());
+    extractInitGoalStates(scanner);
+    extractTasksNames(scanner);
+    extractInitRootTaskIdx(scanner);
+    extractMethods(scanner, pool.get());
+    Log::i("Loaded the grounded problem in %.3f s\n", Timer::elapsedSeconds() - start_time);
+
+    if (_params.isNonzero("simplifyPreds"))
     {
-        _all_fact_vars_goal.push_back(VariableProvider::nextVar());
+        simplifyPredicates();
     }
 
+    initSpecialActions();
+
     if (_params.isNonzero("removeMethodPrecAction"))
     {
         Log::i("Removing the first subtask of each method if it starts with __method_precondition_\n");
@@ -308,20 +775,16 @@ void HtnInstance::loadGroundedProblem(const std::string &grounded_problem_filepa
     // }
 }
 
-void HtnInstance::skipUntil(std::ifstream &file, const std::string &target, int &line_idx)
+bool HtnInstance::skipUntil(TextScanner &scanner, const char *target)
 {
-    std::string line;
-    while (std::getline(file, line))
-    {
-        ++line_idx;
-        if (line == target)
-            return;
-    }
+    if (scanner.skipUntilLine(target))
+        return true;
     // Indicate that the target was not found
-    Log::e("Error: Target string '%s' not found in the file.\n", target.c_str());
+    Log::e("Error: Target string '%s' not found in the file.\n", target);
+    return false;
 }
 
-std::vector<int> HtnInstance::parseIntegerList(std::ifstream &file, int &line_idx)
+std::vector<int> HtnInstance::parseIntegerList(std::istream &file, int &line_idx)
 {
     std::vector<int> numbers;
     std::string line;
@@ -338,42 +801,69 @@ std::vector<int> HtnInstance::parseIntegerList(std::ifstream &file, int &line_id
     return numbers;
 }
 
-void HtnInstance::extractPredicates(std::ifstream &file, int &line_idx)
+size_t HtnInstance::getRecordsPerChunk(size_t num_records, ThreadPool *pool)
 {
-    skipUntil(file, ";; #state features", line_idx);
+    if (pool == nullptr)
+        return std::max(num_records, (size_t)1);
+    size_t num_chunks = (size_t)pool->getNumThreads() * 4;
+    return std::max(MIN_RECORDS_PER_CHUNK, (num_records + num_chunks - 1) / num_chunks);
+}
 
-    std::string line;
-    std::getline(file, line);
-    int num_predicates = std::stoi(line);
+std::vector<TextScanner> HtnInstance::splitIntoChunks(TextScanner &scanner, size_t num_records, size_t lines_per_record, size_t records_per_chunk)
+{
+    // Only the line breaks are looked for here, the chunks are parsed afterwards
+    std::vector<TextScanner> chunks;
+    for (size_t first = 0; first < num_records; first += records_per_chunk)
+    {
+        const char *begin = scanner.getPosition();
+        scanner.skipLines(std::min(records_per_chunk, num_records - first) * lines_per_record);
+        chunks.emplace_back(begin, scanner.getPosition());
+    }
+    return chunks;
+}
+
+void HtnInstance::forEachChunk(ThreadPool *pool, size_t num_chunks, const std::function<void(size_t)> &parse_chunk)
+{
+    if (pool == nullptr)
+    {
+        for (size_t chunk = 0; chunk < num_chunks; chunk++)
+            parse_chunk(chunk);
+        return;
+    }
+    pool->parallelFor(num_chunks, parse_chunk);
+}
+
+void HtnInstance::extractPredicates(TextScanner &scanner)
+{
+    skipUntil(scanner, ";; #state features");
+
+    int num_predicates = scanner.readIntLine();
     _predicates.reserve(num_predicates);
-    ++line_idx;
 
     int pred_id = 0;
-    while (std::getline(file, line) && !line.empty())
+    while (!scanner.atEnd())
     {
+        std::string_view line = scanner.readLine();
+        if (line.empty())
+            break;
         bool is_positive = line[0] == '+';
-        _predicates.emplace_back(pred_id++, is_positive, line);
-        ++line_idx;
+        _predicates.emplace_back(pred_id++, is_positive, std::string(line));
     }
 }
 
-void HtnInstance::extractMutexes(std::ifstream &file, int &line_idx)
+void HtnInstance::extractMutexes(TextScanner &scanner)
 {
-    skipUntil(file, ";; Mutex Groups", line_idx);
-
-    std::string line;
+    skipUntil(scanner, ";; Mutex Groups");
 
     // Ignore the first line
-    std::getline(file, line);
-    ++line_idx;
+    scanner.readLine();
 
     // Each mutex group is in the form:
     // <idx_first_predicate_in_group> <idx_last_predicate_in_group> <name>
-    while (std::getline(file, line) && !line.empty())
+    int idx_first_predicate, idx_last_predicate;
+    while (scanner.readInt(idx_first_predicate) && scanner.readInt(idx_last_predicate))
     {
-        std::istringstream iss(line);
-        int idx_first_predicate, idx_last_predicate;
-        iss >> idx_first_predicate >> idx_last_predicate;
+        scanner.readLine();
         if (idx_first_predicate == idx_last_predicate)
         {
             continue; // Skip empty mutex groups
@@ -385,59 +875,47 @@ void HtnInstance::extractMutexes(std::ifstream &file, int &line_idx)
             mutex_group.push_back(i);
         }
         _mutex.addMutexGroup(mutex_group);
-        ++line_idx;
     }
 
-    Log::i("Line: %s\n", line.c_str());
-
-    skipUntil(file, ";; further strict Mutex Groups", line_idx);
-
-    // Ignore the first line
-    std::getline(file, line);
-    ++line_idx;
-
     // Here we have a list if integers, each integer is a mutex group
-    std::vector<int> mutex_group = parseIntegerList(file, line_idx);
-    while (mutex_group.size() > 1)
+    std::vector<int> mutex_group;
+    for (const char *section : {";; further strict Mutex Groups", ";; further non strict Mutex Groups"})
     {
-        // std::unordered_set<int> mutex_group_set;
-        // for (int i = 0; i < mutex_group.size(); ++i)
-        // {
-        //     mutex_group_set.insert(mutex_group[i]);
-        // }
-        // _mutex.addMutexGroup(mutex_group_set);
-        _mutex.addMutexGroup(mutex_group);
-        mutex_group = parseIntegerList(file, line_idx);
-    }
+        skipUntil(scanner, section);
+        // Ignore the first line
+        scanner.readLine();
 
-    skipUntil(file, ";; further non strict Mutex Groups", line_idx);
-    // Ignore the first line
-    std::getline(file, line);
-    ++line_idx;
+        scanner.readIntegerList(mutex_group);
+        while (mutex_group.size() > 1)
+        {
+            _mutex.addMutexGroup(mutex_group);
+            scanner.readIntegerList(mutex_group);
+        }
+    }
+}
 
-    mutex_group = parseIntegerList(file, line_idx);
-    while (mutex_group.size() > 1)
+// Read a line of effects, return false if one of them is conditional
+static bool readUnconditionalEffects(TextScanner &scanner, std::vector<int> &values, std::vector<int> &effects)
+{
+    // All the even idx elements of the effects list should be 0 (no condition)
+    // and all the odd idx elements should be the predicate ID
+    scanner.readIntegerList(values);
+    effects.clear();
+    for (size_t i = 0; i < values.size(); i++)
     {
-        // std::unordered_set<int> mutex_group_set;
-        // for (int i = 0; i < mutex_group.size(); ++i)
-        // {
-        //     mutex_group_set.insert(mutex_group[i]);
-        // }
-        // _mutex.addMutexGroup(mutex_group_set);
-        _mutex.addMutexGroup(mutex_group);
-        mutex_group = parseIntegerList(file, line_idx);
+        if (i % 2 == 1)
+            effects.push_back(values[i]);
+        else if (values[i] != 0)
+            return false;
     }
+    return true;
 }
 
-void HtnInstance::extractActions(std::ifstream &file, int &line_idx)
+void HtnInstance::extractActions(TextScanner &scanner, ThreadPool *pool)
 {
-    skipUntil(file, ";; Actions", line_idx);
+    skipUntil(scanner, ";; Actions");
 
-    std::string line;
-    std::getline(file, line);
-    int num_actions = std::stoi(line);
-    _actions.reserve(num_actions);
-    ++line_idx;
+    int num_actions = scanner.readIntLine();
 
     /**
      * Each block of $4$ lines describes an action.
@@ -459,94 +937,160 @@ void HtnInstance::extractActions(std::ifstream &file, int &line_idx)
        Note that there might be *two* space between the last integer of each block and the next start of a block.
      */
 
-    int action_id = 0;
-    while (std::getline(file, line) && !line.empty())
-    {
-        int cost = std::stoi(line);
-        ++line_idx;
-
-        std::vector<int> preconditions = parseIntegerList(file, line_idx);
-        std::vector<int> positive_conditional_and_unconditional_effects = parseIntegerList(file, line_idx);
-        std::vector<int> negative_conditional_and_unconditional_effects = parseIntegerList(file, line_idx);
-
-        // Check that all positive and negative effects are unconditional (i.e., no conditional effects)
-        // To do so, all the even idx elements of the effects list should be 0
-        // and all the odd idx elements should be the predicate ID
-        std::vector<int> positive_effects, negative_effects;
-        bool even = true;
-        for (int effect : positive_conditional_and_unconditional_effects)
+    size_t actions_per_chunk = getRecordsPerChunk(num_actions, pool);
+    std::vector<TextScanner> chunks = splitIntoChunks(scanner, num_actions, 4, actions_per_chunk);
+    std::vector<std::vector<Action>> chunk_actions(chunks.size());
+    std::atomic<bool> conditional_effects = false;
+    forEachChunk(pool, chunks.size(), [&](size_t chunk)
+                 {
+        TextScanner &chunk_scanner = chunks[chunk];
+        std::vector<Action> &actions = chunk_actions[chunk];
+        actions.reserve(actions_per_chunk);
+        std::vector<int> values, preconditions, positive_effects, negative_effects;
+        int action_id = chunk * actions_per_chunk;
+        while (!chunk_scanner.atEnd())
         {
-            if (even)
+            // Cost of the action (unused)
+            chunk_scanner.readLine();
+            chunk_scanner.readIntegerList(preconditions);
+            if (!readUnconditionalEffects(chunk_scanner, values, positive_effects) || !readUnconditionalEffects(chunk_scanner, values, negative_effects))
             {
-                if (effect != 0)
-                {
-                    Log::e("Error: Conditional effects are not supported.\n");
-                    return;
-                }
+                conditional_effects = true;
+                return;
             }
+            actions.emplace_back(action_id++, preconditions, positive_effects, negative_effects);
+        } });
+
+    if (conditional_effects)
+    {
+        Log::e("Error: Conditional effects are not supported.\n");
+        return;
+    }
+    _actions.reserve(num_actions);
+    for (std::vector<Action> &actions : chunk_actions)
+    {
+        std::move(actions.begin(), actions.end(), std::back_inserter(_actions));
+    }
+    Log::i("There are %d actions in the grounded problem.\n", num_actions);
+}
+
+void HtnInstance::simplifyPredicates()
+{
+    const int num_predicates = _predicates.size();
+    std::vector<bool> is_changed(num_predicates, false);
+    std::vector<bool> is_read(num_predicates, false);
+    for (const Action &action : _actions)
+    {
+        for (int pred_id : action.getPosEffsIdx())
+            is_changed[pred_id] = true;
+        for (int pred_id : action.getNegEffsIdx())
+            is_changed[pred_id] = true;
+        for (int pred_id : action.getPreconditionsIdx())
+            is_read[pred_id] = true;
+    }
+    for (int pred_id : _goal_state)
+    {
+        is_read[pred_id] = true;
+    }
+
+    // New index of each predicate (-1 if removed)
+    std::vector<int> new_pred_id(num_predicates, -1);
+    std::vector<Predicate> predicates;
+    int num_rigid_true = 0;
+    int num_irrelevant = 0;
+    for (int pred_id = 0; pred_id < num_predicates; ++pred_id)
+    {
+        bool rigid_true = !is_changed[pred_id] && _init_state.count(pred_id);
+        if (rigid_true || !is_read[pred_id])
+        {
+            if (rigid_true)
+                num_rigid_true++;
             else
-            {
-                positive_effects.push_back(effect);
-            }
-            even = !even;
+                num_irrelevant++;
+            continue;
         }
-        even = true;
+        new_pred_id[pred_id] = predicates.size();
+        predicates.emplace_back(predicates.size(), _predicates[pred_id].isPositive(), _predicates[pred_id].getName());
+    }
 
-        for (int effect : negative_conditional_and_unconditional_effects)
+    Log::i("Predicate simplification: removed %d/%d predicates (%d rigid true in the initial state, %d irrelevant)\n",
+           num_predicates - (int)predicates.size(), num_predicates, num_rigid_true, num_irrelevant);
+    if ((int)predicates.size() == num_predicates)
+    {
+        return;
+    }
+
+    auto renumber = [&new_pred_id](const auto &pred_ids)
+    {
+        std::vector<int> new_pred_ids;
+        for (int pred_id : pred_ids)
         {
-            if (even)
-            {
-                if (effect != 0)
-                {
-                    Log::e("Error: Conditional effects are not supported.\n");
-                    return;
-                }
-            }
-            else
-            {
-                negative_effects.push_back(effect);
-            }
-            even = !even;
+            if (new_pred_id[pred_id] != -1)
+                new_pred_ids.push_back(new_pred_id[pred_id]);
         }
+        return new_pred_ids;
+    };
 
-        _actions.emplace_back(action_id++, preconditions, positive_effects, negative_effects);
+    std::vector<Action> actions;
+    actions.reserve(_actions.size());
+    for (const Action &action : _actions)
+    {
+        actions.emplace_back(action.getId(), renumber(action.getPreconditionsIdx()), renumber(action.getPosEffsIdx()), renumber(action.getNegEffsIdx()));
+        actions.back().addName(action.getName());
     }
-    Log::i("There are %d actions in the grounded problem.\n", num_actions);
+    _actions = std::move(actions);
+
+    std::vector<int> init_state = renumber(_init_state);
+    _init_state = std::unordered_set<int>(init_state.begin(), init_state.end());
+    std::vector<int> goal_state = renumber(_goal_state);
+    _goal_state = std::unordered_set<int>(goal_state.begin(), goal_state.end());
+
+    Mutex mutex;
+    for (const std::vector<int> &group : _mutex.getMutexGroups())
+    {
+        std::vector<int> new_group = renumber(group);
+        if (new_group.size() > 1)
+            mutex.addMutexGroup(new_group);
+    }
+    _mutex = std::move(mutex);
+
+    _predicates = std::move(predicates);
 }
 
-void HtnInstance::extractInitGoalStates(std::ifstream &file, int &line_idx)
+void HtnInstance::extractInitGoalStates(TextScanner &scanner)
 {
 
     /**
      * Each such non-negative integer $i$ indicates that the state feature $i$ holds in the initial state.
        Any state feature that does not occur in this line is false in the initial state
      */
-    skipUntil(file, ";; initial state", line_idx);
-    std::vector<int> init_state = parseIntegerList(file, line_idx);
+    std::vector<int> state;
+    skipUntil(scanner, ";; initial state");
+    scanner.readIntegerList(state);
     // Convert the initial state to a unordered set
-    _init_state = std::unordered_set<int>(init_state.begin(), init_state.end());
+    _init_state = std::unordered_set<int>(state.begin(), state.end());
 
-    skipUntil(file, ";; goal", line_idx);
-    std::vector<int> goal_state = parseIntegerList(file, line_idx);
+    skipUntil(scanner, ";; goal");
+    scanner.readIntegerList(state);
     // Convert the goal state to a unordered set
-    _goal_state = std::unordered_set<int>(goal_state.begin(), goal_state.end());
+    _goal_state = std::unordered_set<int>(state.begin(), state.end());
 }
 
-void HtnInstance::extractTasksNames(std::ifstream &file, int &line_idx)
+void HtnInstance::extractTasksNames(TextScanner &scanner)
 {
-    skipUntil(file, ";; tasks (primitive and abstract)", line_idx);
+    skipUntil(scanner, ";; tasks (primitive and abstract)");
 
-    std::string line;
-    std::getline(file, line);
-    int num_tasks = std::stoi(line);
+    int num_tasks = scanner.readIntLine();
     _abstr_tasks.reserve(num_tasks - _actions.size());
-    ++line_idx;
 
     int task_id = 0;
-    while (std::getline(file, line) && !line.empty())
+    while (!scanner.atEnd())
     {
+        std::string_view line = scanner.readLine();
+        if (line.empty())
+            break;
         bool is_abstract = line[0] == '1';
-        std::string task_name = line.substr(2);
+        std::string task_name(line.substr(2));
 
         if (is_abstract)
         {
@@ -556,30 +1100,21 @@ void HtnInstance::extractTasksNames(std::ifstream &file, int &line_idx)
         {
             _actions[task_id].addName(task_name);
         }
-        ++line_idx;
         ++task_id;
     }
 }
 
-void HtnInstance::extractInitRootTaskIdx(std::ifstream &file, int &line_idx)
+void HtnInstance::extractInitRootTaskIdx(TextScanner &scanner)
 {
-    skipUntil(file, ";; initial abstract task", line_idx);
-
-    std::string line;
-    std::getline(file, line);
-    _root_task_idx = std::stoi(line);
-    ++line_idx;
+    skipUntil(scanner, ";; initial abstract task");
+    _root_task_idx = scanner.readIntLine();
 }
 
-void HtnInstance::extractMethods(std::ifstream &file, int &line_idx)
+void HtnInstance::extractMethods(TextScanner &scanner, ThreadPool *pool)
 {
-    skipUntil(file, ";; methods", line_idx);
+    skipUntil(scanner, ";; methods");
 
-    std::string line;
-    std::getline(file, line);
-    int num_methods = std::stoi(line);
-    _methods.reserve(num_methods);
-    ++line_idx;
+    int num_methods = scanner.readIntLine();
 
     /**
      * Each method is described by a block of $4$ consecutive lines.
@@ -600,53 +1135,63 @@ void HtnInstance::extractMethods(std::ifstream &file, int &line_idx)
        contains transitively implied ordering.
      */
 
-    int method_id = 0;
-    while (std::getline(file, line) && !line.empty())
-    {
-        std::string method_name = line;
-        ++line_idx;
+    size_t methods_per_chunk = getRecordsPerChunk(num_methods, pool);
+    std::vector<TextScanner> chunks = splitIntoChunks(scanner, num_methods, 4, methods_per_chunk);
+    std::vector<std::vector<Method>> chunk_methods(chunks.size());
+    // First error of each chunk
+    std::vector<std::string> chunk_errors(chunks.size());
+    forEachChunk(pool, chunks.size(), [&](size_t chunk)
+                 {
+        TextScanner &chunk_scanner = chunks[chunk];
+        std::vector<Method> &methods = chunk_methods[chunk];
+        methods.reserve(methods_per_chunk);
+        std::vector<int> abstract_task_ids, subtasks_ids, ordering_values;
+        int method_id = chunk * methods_per_chunk;
+        while (!chunk_scanner.atEnd())
+        {
+            std::string method_name(chunk_scanner.readLine());
 
-        std::vector<int> abstract_task_ids = parseIntegerList(file, line_idx);
+            chunk_scanner.readIntegerList(abstract_task_ids);
+            if (abstract_task_ids.size() != 1)
+            {
+                chunk_errors[chunk] = (abstract_task_ids.empty() ? "No abstract task ID found for method " : "Multiple abstract task IDs found for method ") + method_name;
+                return;
+            }
 
-        if (abstract_task_ids.empty())
-        {
-            Log::e("Error: No abstract task ID found for method %s\n", method_name.c_str());
-            return;
-        }
-        if (abstract_task_ids.size() > 1)
-        {
-            Log::e("Error: Multiple abstract task IDs found for method %s\n", method_name.c_str());
-            return;
-        }
+            chunk_scanner.readIntegerList(subtasks_ids);
+            chunk_scanner.readIntegerList(ordering_values);
+            std::vector<std::pair<int, int>> ordering_constains;
+            ordering_constains.reserve(ordering_values.size() / 2);
+            for (size_t i = 0; i + 1 < ordering_values.size(); i += 2)
+            {
+                ordering_constains.emplace_back(ordering_values[i], ordering_values[i + 1]);
+            }
 
-        int abstract_task_id = abstract_task_ids[0];
-        std::vector<int> subtasks_ids = parseIntegerList(file, line_idx);
+            if (!_partial_order_problem)
+            {
+                sortSubtasks(subtasks_ids, ordering_constains);
+            }
+
+            methods.emplace_back(method_id++, std::move(method_name), abstract_task_ids[0], subtasks_ids, std::move(ordering_constains));
+        } });
 
-        std::vector<std::pair<int, int>> ordering_constains;
-        std::getline(file, line);
-        std::istringstream iss(line);
-        int value1, value2;
-        while (iss >> value1)
+    for (const std::string &error : chunk_errors)
+    {
+        if (!error.empty())
         {
-            if (value1 == -1)
-                break;
-            iss >> value2;
-            ordering_constains.emplace_back(value1, value2);
+            Log::e("Error: %s\n", error.c_str());
+            return;
         }
-        ++line_idx;
-
-        if (!_partial_order_problem)
+    }
+    _methods.reserve(num_methods);
+    for (std::vector<Method> &methods : chunk_methods)
+    {
+        for (Method &method : methods)
         {
-            sortSubtasks(subtasks_ids, ordering_constains);
+            // Add the method to the abstract task
+            _abstr_tasks[method.getParentTaskIdx() - _actions.size()].addDecompositionMethod(method.getId());
+            _methods.push_back(std::move(method));
         }
-
-        // Pass both maps to the constructor
-        _methods.emplace_back(method_id, method_name, abstract_task_id, subtasks_ids, ordering_constains);
-
-        // Add the method to the abstract task
-        _abstr_tasks[abstract_task_id - _actions.size()].addDecompositionMethod(method_id);
-                
-        ++method_id;
     }
 }
 
@@ -5,6 +5,8 @@
 #include <string>
 #include <optional>
 #include <fstream>
+#include <functional>
+#include <string_view>
 #include <unordered_set>
 #include <map> // Added for std::map
 #include "data/action.h"
@@ -13,6 +15,8 @@
 #include "util/params.h"
 #include "data/mutex.h"
 #include "util/statistics.h"
+#include "util/text_scanner.h"
+#include "util/thread_pool.h"
 
 class HtnInstance
 {
@@ -66,6 +70,17 @@ private:
      */
     std::optional<std::string> groundProblem(const std::string &parsed_problem_filepath);
 
+    /**
+     * Parse and ground the problem by chaining pandaPIparser and pandaPIgrounder through pipes,
+     * without intermediate files. The grounded problem is kept in memory.
+     *
+     * @param domain_filepath The domain file to parse.
+     * @param problem_filepath The problem file to parse.
+     * @param grounded_problem Filled with the grounded problem.
+     * @return true if successful, false if the intermediate files must be used instead.
+     */
+    bool parseAndGroundThroughPipes(const std::string &domain_filepath, const std::string &problem_filepath, std::string &grounded_problem);
+
     /**
      * Load the grounded problem from file and populate internal structures.
      *
@@ -74,13 +89,61 @@ private:
     void loadGroundedProblem(const std::string &grounded_problem_filepath);
 
     /**
-     * Skip lines in the file until a specific target line is found.
+     * Load the grounded problem from its contents in memory and populate internal structures.
+     * The actions and methods are parsed in parallel with -loadThreads > 1.
      *
-     * @param file The file to read from.
+     * @param contents The grounded problem.
+     */
+    void loadGroundedProblem(std::string_view contents);
+
+    /**
+     * Create the blank, init and goal actions and the fact variables of the goal state,
+     * once the predicates and the initial and goal states are known.
+     */
+    void initSpecialActions();
+
+    /**
+     * Key of the snapshot of this instance (-snapshots): the sizes and hashes of the contents of the
+     * domain and problem files, and the parameters used by the preprocessing.
+     */
+    std::string getSnapshotKey() const;
+
+    /**
+     * Path of the snapshot of a key, in -snapshotDir. Its name is a hash of the key.
+     */
+    std::string getSnapshotPath(const std::string &key) const;
+
+    /**
+     * Write the fully preprocessed instance (after the effects inference) into a binary snapshot.
+     *
+     * @param snapshot_path The snapshot file.
+     * @param key The key of the instance, stored in the snapshot.
+     */
+    void saveSnapshot(const std::string &snapshot_path, const std::string &key) const;
+
+    /**
+     * Load the preprocessed instance from a snapshot, instead of parsing, grounding and preprocessing it.
+     *
+     * @param snapshot_path The snapshot file.
+     * @param key The key of the instance, which must be the one stored in the snapshot.
+     * @return true if the snapshot exists and is valid, false if the instance must be computed.
+     */
+    bool loadSnapshot(const std::string &snapshot_path, const std::string &key);
+
+    /**
+     * Check that all the indices of the instance loaded from a snapshot (predicates, tasks, methods,
+     * subtasks and structures) are within the loaded counts.
+     */
+    bool isSnapshotConsistent() const;
+
+    /**
+     * Skip lines until a specific target line is found.
+     *
+     * @param scanner The scanner of the grounded problem.
      * @param target The target line to search for.
-     * @param line_idx The index of the current line (updated to the found line).
+     * @return true if the target was found, the scanner being on the next line.
      */
-    void skipUntil(std::ifstream &file, const std::string &target, int &line_idx);
+    bool skipUntil(TextScanner &scanner, const char *target);
 
     /**
      * Read a space-separated list of integers from a file.
@@ -89,63 +152,84 @@ private:
      * @param line_idx The current line index (incremented after reading).
      * @return A vector containing the parsed integers.
      */
-    std::vector<int> parseIntegerList(std::ifstream &file, int &line_idx);
+    std::vector<int> parseIntegerList(std::istream &file, int &line_idx);
+
+    /**
+     * Number of records (actions or methods) of a section parsed by each task: the whole section
+     * without a thread pool, a few chunks per thread otherwise.
+     */
+    static size_t getRecordsPerChunk(size_t num_records, ThreadPool *pool);
+
+    /**
+     * Split the next num_records records of lines_per_record lines each into chunks of records_per_chunk
+     * records which can be parsed independently. The scanner is moved after the records.
+     */
+    static std::vector<TextScanner> splitIntoChunks(TextScanner &scanner, size_t num_records, size_t lines_per_record, size_t records_per_chunk);
+
+    // Call parse_chunk on each chunk, in parallel if a pool is given
+    static void forEachChunk(ThreadPool *pool, size_t num_chunks, const std::function<void(size_t)> &parse_chunk);
 
     /**
      * Extract predicates from the grounded problem and store them in `_predicates`.
      *
-     * @param file The input file stream.
-     * @param line_idx The index of the line to start extraction from.
+     * @param scanner The scanner of the grounded problem.
      */
-    void extractPredicates(std::ifstream &file, int &line_idx);
+    void extractPredicates(TextScanner &scanner);
 
     /**
      * Extract actions from the grounded problem and store them in `_actions`.
      *
-     * @param file The input file stream.
-     * @param line_idx The index of the line to start extraction from.
+     * @param scanner The scanner of the grounded problem.
+     * @param pool The threads parsing the actions in parallel, or nullptr.
      */
-    void extractActions(std::ifstream &file, int &line_idx);
+    void extractActions(TextScanner &scanner, ThreadPool *pool);
 
     /**
      * Extract mutexes from the grounded problem and store them in `_mutex`.
      *
-     * @param file The input file stream.
-     * @param line_idx The index of the line to start extraction from.
+     * @param scanner The scanner of the grounded problem.
      */
-    void extractMutexes(std::ifstream &file, int &line_idx);
+    void extractMutexes(TextScanner &scanner);
 
     /**
      * Extract initial and goal states from the grounded problem.
      *
-     * @param file The input file stream.
-     * @param line_idx The index of the line to start extraction from.
+     * @param scanner The scanner of the grounded problem.
      */
-    void extractInitGoalStates(std::ifstream &file, int &line_idx);
+    void extractInitGoalStates(TextScanner &scanner);
 
     /**
      * Extract task names and populate `_abstr_tasks` and `_actions`.
      *
-     * @param file The input file stream.
-     * @param line_idx The index of the line to start extraction from.
+     * @param scanner The scanner of the grounded problem.
      */
-    void extractTasksNames(std::ifstream &file, int &line_idx);
+    void extractTasksNames(TextScanner &scanner);
 
     /**
-     * Extract the root task index from the grounded problem file.
+     * Extract the root task index from the grounded problem.
      *
-     * @param file The input file stream.
-     * @param line_idx The index of the line to start extraction from.
+     * @param scanner The scanner of the grounded problem.
      */
-    void extractInitRootTaskIdx(std::ifstream &file, int &line_idx);
+    void extractInitRootTaskIdx(TextScanner &scanner);
 
     /**
      * Extract methods and store them in `_methods`.
      *
-     * @param file The input file stream.
-     * @param line_idx The index of the line to start extraction from.
+     * @param scanner The scanner of the grounded problem.
+     * @param pool The threads parsing the methods in parallel, or nullptr.
+     */
+    void extractMethods(TextScanner &scanner, ThreadPool *pool);
+
+    /**
+     * Remove the predicates which do not need a variable in the encoding:
+     * - rigid predicates (no action can change them) which are true in the initial state are
+     *   removed from the preconditions and from the goal, as they always hold.
+     * - irrelevant predicates (no action precondition nor goal reads them) are removed from the effects.
+     * The remaining predicates are renumbered. Rigid predicates false in the initial state but read by
+     * some precondition or by the goal are kept, so that the encoding still forbids these actions.
+     * Must be called once the actions are extracted and before any method precondition is computed.
      */
-    void extractMethods(std::ifstream &file, int &line_idx);
+    void simplifyPredicates();
 
     /**
      * Sort subtasks based on ordering constraints.
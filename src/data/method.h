@@ -26,7 +26,7 @@ private:
 
 public:
     Method(int id, std::string name, int parent_task_idx, std::vector<int> subtasks_idx, std::vector<std::pair<int, int>> ordering_constraints = {})
-        : _id(id), _name(name), _parent_task_idx(parent_task_idx), _subtasks_idx(subtasks_idx), _ordering_constraints(ordering_constraints) {}
+        : _id(id), _name(std::move(name)), _parent_task_idx(parent_task_idx), _subtasks_idx(std::move(subtasks_idx)), _ordering_constraints(std::move(ordering_constraints)) {}
 
     const std::string getName() const
     {
@@ -38,6 +38,11 @@ public:
         return _id;
     }
 
+    int getParentTaskIdx() const
+    {
+        return _parent_task_idx;
+    }
+
     const std::vector<int> &getSubtasksIdx() const
     {
         return _subtasks_idx;
@@ -58,11 +63,11 @@ public:
         _ordering_constraints.push_back({idx_subtask_first, idx_subtask_second});
     }
 
-    void setPreconditions(std::unordered_set<int> preconditions_idx) { _preconditions_idx = preconditions_idx; }
-    void setPositiveEffects(std::unordered_set<int> pos_effs_idx) { _pos_effs_idx = pos_effs_idx; }
-    void setNegativeEffects(std::unordered_set<int> neg_effs_idx) { _neg_effs_idx = neg_effs_idx; }
-    void setPossiblePositiveEffects(std::unordered_set<int> poss_pos_effs_idx) { _poss_pos_effs_idx = poss_pos_effs_idx; }
-    void setPossibleNegativeEffects(std::unordered_set<int> poss_neg_effs_idx) { _poss_neg_effs_idx = poss_neg_effs_idx; }
+    void setPreconditions(std::unordered_set<int> preconditions_idx) { _preconditions_idx = std::move(preconditions_idx); }
+    void setPositiveEffects(std::unordered_set<int> pos_effs_idx) { _pos_effs_idx = std::move(pos_effs_idx); }
+    void setNegativeEffects(std::unordered_set<int> neg_effs_idx) { _neg_effs_idx = std::move(neg_effs_idx); }
+    void setPossiblePositiveEffects(std::unordered_set<int> poss_pos_effs_idx) { _poss_pos_effs_idx = std::move(poss_pos_effs_idx); }
+    void setPossibleNegativeEffects(std::unordered_set<int> poss_neg_effs_idx) { _poss_neg_effs_idx = std::move(poss_neg_effs_idx); }
 
     const std::unordered_set<int> &getPreconditionsIdx() const { return _preconditions_idx; }
     const std::unordered_set<int> &getPosEffsIdx() const { return _pos_effs_idx; }
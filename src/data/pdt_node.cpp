@@ -1,4 +1,5 @@
 #include "data/pdt_node.h"
+#include "data/pdt_node_arena.h"
 #include "util/names.h"
 #include "sat/variable_provider.h"
 #include "util/log.h"
@@ -29,27 +30,27 @@ void PdtNode::addActionRepetitionIdx(int action_idx)
     _actions_repetition_idx.insert(action_idx);
 }
 
-const std::unordered_map<int, std::unordered_set<int>> &PdtNode::getParentsOfMethod() const
+const FlatMap<int, FlatSet<int>> &PdtNode::getParentsOfMethod() const
 {
     return _parents_of_method;
 }
 
-const std::unordered_map<int, std::unordered_set<std::pair<int, OpType>, PairHash>> &PdtNode::getParentsOfAction() const
+const FlatMap<int, FlatSet<std::pair<int, OpType>>> &PdtNode::getParentsOfAction() const
 {
     return _parents_of_action;
 }
 
-const std::unordered_set<int> &PdtNode::getMethodsIdx() const
+const FlatSet<int> &PdtNode::getMethodsIdx() const
 {
     return _methods_idx;
 }
 
-const std::unordered_set<int> &PdtNode::getActionsIdx() const
+const FlatSet<int> &PdtNode::getActionsIdx() const
 {
     return _actions_idx;
 }
 
-const std::unordered_set<int> &PdtNode::getActionsRepetitionIdx() const
+const FlatSet<int> &PdtNode::getActionsRepetitionIdx() const
 {
     return _actions_repetition_idx;
 }
@@ -69,12 +70,12 @@ const std::vector<int> &PdtNode::getFactVariables() const
     return _fact_variables;
 }
 
-const std::unordered_map<int, int> &PdtNode::getMethodAndVariables() const
+const FlatMap<int, int> &PdtNode::getMethodAndVariables() const
 {
     return _method_variables;
 }
 
-const std::unordered_map<int, int> &PdtNode::getActionAndVariables() const
+const FlatMap<int, int> &PdtNode::getActionAndVariables() const
 {
     return _action_variables;
 }
@@ -104,10 +105,8 @@ const std::string PdtNode::getPositionString() const
     return std::to_string(_layer) + "_" + std::to_string(_pos);
 }
 
-void PdtNode::assignSatVariables(const HtnInstance &htn, const bool print_var_names, const bool is_po)
+void PdtNode::assignSatVariables(const HtnInstance &htn, const bool print_var_names, const bool is_po, const bool alias_facts, const bool use_method_effects)
 {
-    const int num_predicates = htn.getNumPredicates();
-
     // Assign a variable to each method
     for (int method_idx : _methods_idx)
     {
@@ -159,15 +158,7 @@ void PdtNode::assignSatVariables(const HtnInstance &htn, const bool print_var_na
     }
     else
     {
-        for (int pred_id = 0; pred_id < num_predicates; ++pred_id)
-        {
-            _fact_variables.push_back(VariableProvider::nextVar());
-            if (print_var_names)
-            {
-                std::string pred_name = htn.getPredicateById(pred_id).getName() + "__" + getPositionString();
-                Log::i("PVN: %d %s\n", _fact_variables[pred_id], pred_name.c_str());
-            }
-        }
+        assignFactVariables(htn, print_var_names, alias_facts && is_po, use_method_effects);
     }
 
     // Assign a variable to the prim
@@ -204,6 +195,72 @@ void PdtNode::assignSatVariables(const HtnInstance &htn, const bool print_var_na
     }
 }
 
+void PdtNode::assignFactVariables(const HtnInstance &htn, const bool print_var_names, const bool alias_facts, const bool use_method_effects)
+{
+    const int num_predicates = htn.getNumPredicates();
+    for (int pred_id = 0; pred_id < num_predicates; ++pred_id)
+    {
+        _fact_variables.push_back(VariableProvider::nextVar());
+        if (print_var_names)
+        {
+            std::string pred_name = htn.getPredicateById(pred_id).getName() + "__" + getPositionString();
+            Log::i("PVN: %d %s\n", _fact_variables[pred_id], pred_name.c_str());
+        }
+    }
+
+    if (!alias_facts || _possible_previous_nodes.size() != 1)
+    {
+        return;
+    }
+    std::vector<bool> changed_by_previous_node = _possible_previous_nodes.begin()->first->computePredicatesChangedByOps(htn, use_method_effects);
+    _aliased_facts.resize(num_predicates, false);
+    for (int pred_id = 0; pred_id < num_predicates; ++pred_id)
+    {
+        if (!changed_by_previous_node[pred_id])
+        {
+            _aliased_facts[pred_id] = true;
+            _num_aliased_fact_variables++;
+        }
+    }
+}
+
+std::vector<bool> PdtNode::computePredicatesChangedByOps(const HtnInstance &htn, const bool use_method_effects, const bool only_added) const
+{
+    const int num_predicates = htn.getNumPredicates();
+    // Without the effects of the methods, the frame axioms do not hold for a non primitive node
+    if (!use_method_effects && !_methods_idx.empty())
+    {
+        return std::vector<bool>(num_predicates, true);
+    }
+
+    std::vector<bool> changed(num_predicates, false);
+    for (int action_idx : _actions_idx)
+    {
+        const Action &action = htn.getActionById(action_idx);
+        for (int pred_id : action.getPosEffsIdx())
+            changed[pred_id] = true;
+        if (only_added)
+            continue;
+        for (int pred_id : action.getNegEffsIdx())
+            changed[pred_id] = true;
+    }
+    for (int method_idx : _methods_idx)
+    {
+        const Method &method = htn.getMethodById(method_idx);
+        for (int pred_id : method.getPosEffsIdx())
+            changed[pred_id] = true;
+        for (int pred_id : method.getPossPosEffsIdx())
+            changed[pred_id] = true;
+        if (only_added)
+            continue;
+        for (int pred_id : method.getNegEffsIdx())
+            changed[pred_id] = true;
+        for (int pred_id : method.getPossNegEffsIdx())
+            changed[pred_id] = true;
+    }
+    return changed;
+}
+
 size_t PdtNode::computeNumberOfChildren(HtnInstance &htn)
 {
     size_t num_children = 1;
@@ -223,7 +280,7 @@ void PdtNode::expand(HtnInstance &htn)
     // Create the children
     for (size_t i = 0; i < num_children; ++i)
     {
-        PdtNode *child = new PdtNode(this);
+        PdtNode *child = _arena->create(this);
         _children.push_back(child);
     }
 
@@ -297,34 +354,43 @@ void PdtNode::addNodeThatMustBeExecutedAfter(PdtNode *node)
     _node_that_must_be_executed_after.insert(node);
 }
 
-const std::unordered_set<PdtNode *> PdtNode::collectLeafChildren()
+void PdtNode::forgetDeeperNodes()
 {
-    std::unordered_set<PdtNode *> leaf_children;
+    _node_that_must_be_executed_before.eraseIf([this](const PdtNode *node)
+                                               { return node->_layer > _layer; });
+    _node_that_must_be_executed_after.eraseIf([this](const PdtNode *node)
+                                              { return node->_layer > _layer; });
+}
 
+void PdtNode::discardChildren()
+{
+    _children.clear();
+}
+
+void PdtNode::collectLeafChildren(std::vector<PdtNode *> &leaf_children)
+{
     if (_children.empty())
     {
-        leaf_children.insert(this);
-        return leaf_children;
+        leaf_children.push_back(this);
+        return;
     }
 
     for (PdtNode *child : _children)
     {
-        std::unordered_set<PdtNode *> child_leaf_children = child->collectLeafChildren();
-        leaf_children.insert(child_leaf_children.begin(), child_leaf_children.end());
+        child->collectLeafChildren(leaf_children);
     }
-    return leaf_children;
 }
 
 void PdtNode::expandPOWithBefore(HtnInstance &htn)
 {
     // Collect all the nodes that must be executed before the children nodes
-    std::unordered_set<PdtNode *> nodes_that_must_be_executed_before;
+    std::vector<PdtNode *> leaf_children;
     for (PdtNode *node : _node_that_must_be_executed_before)
     {
         // Collect all the leaf children of the node
-        std::unordered_set<PdtNode *> leaf_children = node->collectLeafChildren();
-        nodes_that_must_be_executed_before.insert(leaf_children.begin(), leaf_children.end());
+        node->collectLeafChildren(leaf_children);
     }
+    const PdtNodeSet nodes_that_must_be_executed_before(std::move(leaf_children));
 
     // Time to crack the number of children and ordering that must be found
     // Optimized to use method structures
@@ -385,7 +451,7 @@ void PdtNode::expandPOWithBefore(HtnInstance &htn)
     for (size_t i = 0; i < num_children; ++i)
     {
         dag_node_id_to_child_id[compressedDAG.nodes[i].id] = i;
-        PdtNode *child = new PdtNode(this);
+        PdtNode *child = _arena->create(this);
         _children.push_back(child);
         Log::d("Creating child %s\n", TOSTR(*child));
     }
@@ -418,9 +484,9 @@ void PdtNode::expandPOWithBefore(HtnInstance &htn)
         bool must_be_first_child = true;
 
         // Indicate all the nodes that must be executed before this child
+        child->_node_that_must_be_executed_before.insert(nodes_that_must_be_executed_before);
         for (PdtNode *node : nodes_that_must_be_executed_before)
         {
-            child->addNodeThatMustBeExecutedBefore(node);
             node->addNodeThatMustBeExecutedAfter(child);
         }
         // Is there other children of this position that must be executed before this child?
@@ -478,11 +544,11 @@ void PdtNode::expandPOWithBefore(HtnInstance &htn)
     if (num_children == 0)
     {
         // Only actions in this position, repeat the action in the first child
-        PdtNode *child = new PdtNode(this);
+        PdtNode *child = _arena->create(this);
         _children.push_back(child);
+        child->_node_that_must_be_executed_before.insert(nodes_that_must_be_executed_before);
         for (PdtNode *node : nodes_that_must_be_executed_before)
         {
-            child->addNodeThatMustBeExecutedBefore(node);
             node->addNodeThatMustBeExecutedAfter(child);
         }
         for (int action_idx : _actions_idx)
@@ -653,7 +719,7 @@ void PdtNode::createChildren(HtnInstance &htn)
     // Create the children
     for (size_t i = 0; i < num_children; ++i)
     {
-        PdtNode *child = new PdtNode(this);
+        PdtNode *child = _arena->create(this);
         _children.push_back(child);
     }
 }
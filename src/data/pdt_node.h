@@ -1,13 +1,11 @@
 #ifndef PDT_NODE_H
 #define PDT_NODE_H
 
-#include <unordered_set>
-#include <unordered_map>
 #include <vector>
-#include <utility>    // For std::pair
-#include <functional> // For std::hash
+#include <utility> // For std::pair
 
 #include "data/htn_instance.h"
+#include "util/flat_map.h"
 
 enum class OpType
 {
@@ -23,40 +21,40 @@ enum class OrderingConstrains
     NO_SIBLING_ORDERING,
 };
 
-// Define a custom hash function for std::pair<int, OpType>
-// Needed because std::unordered_set requires a hash function for its elements.
-struct PairHash
-{
-    template <class T1, class T2>
-    std::size_t operator()(const std::pair<T1, T2> &p) const
-    {
-        // Hash the first element (int)
-        auto hash1 = std::hash<T1>{}(p.first);
-        // Hash the second element (OpType enum). Need to cast enum to underlying type (int)
-        auto hash2 = std::hash<std::underlying_type_t<T2>>{}(static_cast<std::underlying_type_t<T2>>(p.second));
+class PdtNode;
+class PdtNodeArena;
 
-        // Combine the two hash values. Using boost::hash_combine logic:
-        return hash1 ^ (hash2 + 0x9e3779b9 + (hash1 << 6) + (hash1 >> 2));
-    }
+// Orders the nodes by creation, so that iterating over a set of nodes is deterministic
+struct PdtNodeLess
+{
+    bool operator()(const PdtNode *a, const PdtNode *b) const;
 };
 
+using PdtNodeSet = FlatSet<PdtNode *, PdtNodeLess>;
+template <class V>
+using PdtNodeMap = FlatMap<PdtNode *, V, PdtNodeLess>;
+
 class PdtNode
 {
 private:
+    int _id;
     int _layer;
     int _pos;
     int _offset;
 
-    std::unordered_set<int> _methods_idx;
-    std::unordered_set<int> _actions_idx;
-    std::unordered_set<int> _actions_repetition_idx;
+    FlatSet<int> _methods_idx;
+    FlatSet<int> _actions_idx;
+    FlatSet<int> _actions_repetition_idx;
 
-    std::unordered_map<int, std::unordered_set<int>> _parents_of_method;                              // Key: method_idx, Value: set of parent_method_idx
-    std::unordered_map<int, std::unordered_set<std::pair<int, OpType>, PairHash>> _parents_of_action; // Key: action_idx, Value: set of {parent_idx, parent_type}
+    FlatMap<int, FlatSet<int>> _parents_of_method;                              // Key: method_idx, Value: set of parent_method_idx
+    FlatMap<int, FlatSet<std::pair<int, OpType>>> _parents_of_action; // Key: action_idx, Value: set of {parent_idx, parent_type}
 
-    std::unordered_map<int, int> _method_variables;
-    std::unordered_map<int, int> _action_variables;
+    FlatMap<int, int> _method_variables;
+    FlatMap<int, int> _action_variables;
     std::vector<int> _fact_variables; // Indexed by predicate ID
+    // Predicates which the unique possible previous node cannot change (with fact aliasing, empty otherwise)
+    std::vector<bool> _aliased_facts;
+    int _num_aliased_fact_variables = 0;
     int _prim_var;
     int _leaf_overleaf_var = -1; // Variable that indicates if the node is a leaf overleaf (used for PO)
 
@@ -65,31 +63,32 @@ private:
     int _ts_solution = -1;
 
     // Only used for PO (TODO could be optimized for all group of methods which share the same ordering and same number of subtasks)
-    std::unordered_map<int, int> _parent_method_idx_to_subtask_idx; // Key: method_idx, Value: subtask_idx of this method in this position
+    FlatMap<int, int> _parent_method_idx_to_subtask_idx; // Key: method_idx, Value: subtask_idx of this method in this position
 
-    std::unordered_set<PdtNode *> _node_that_must_be_executed_before;
-    std::unordered_set<PdtNode *> _node_that_must_be_executed_after;
+    PdtNodeSet _node_that_must_be_executed_before;
+    PdtNodeSet _node_that_must_be_executed_after;
     int node_executed_var;
 
-    std::unordered_map<const PdtNode *, int> _before_vars; // Var that inidicate that the current node is executed before the other node
-
     // Try with before and after
     bool _can_be_first_child = true;
     bool _can_be_last_child = true;
     // test
     bool _must_be_first_child = false;
-    std::unordered_map<PdtNode *, OrderingConstrains> _possible_next_nodes;
-    std::unordered_map<PdtNode *, OrderingConstrains> _possible_previous_nodes;
-    std::unordered_map<PdtNode *, int> _possible_next_node_variable;
+    PdtNodeMap<OrderingConstrains> _possible_next_nodes;
+    PdtNodeMap<OrderingConstrains> _possible_previous_nodes;
+    PdtNodeMap<int> _possible_next_node_variable;
 
     std::string _name;
 
+    // Store of all the nodes of the tree, in which the children are allocated
+    PdtNodeArena *_arena;
     const PdtNode *_parent;
     std::vector<PdtNode *> _children;
 
 public:
-    PdtNode(const PdtNode *parent)
-        : _parent(parent)
+    // Nodes are only created by PdtNodeArena::create
+    PdtNode(PdtNodeArena *arena, const PdtNode *parent, int id)
+        : _id(id), _arena(arena), _parent(parent)
     {
         if (parent != nullptr)
         {
@@ -106,28 +105,23 @@ public:
             _name = "root";
         }
     }
-    ~PdtNode()
-    {
-        for (PdtNode *child : _children)
-            delete child;
-    }
 
     void addMethodIdx(int method_idx);
     void addActionIdx(int action_idx);
     void addActionRepetitionIdx(int action_idx);
     void addParentOfMethod(int method_idx, int parent_method_idx);
     void addParentOfAction(int action_idx, int parent_idx, OpType parent_type);
-    const std::unordered_set<int> &getMethodsIdx() const;
-    const std::unordered_set<int> &getActionsIdx() const;
-    const std::unordered_set<int> &getActionsRepetitionIdx() const;
+    const FlatSet<int> &getMethodsIdx() const;
+    const FlatSet<int> &getActionsIdx() const;
+    const FlatSet<int> &getActionsRepetitionIdx() const;
     std::vector<PdtNode *> &getChildren();
     const PdtNode *getParent() const;
-    const std::unordered_map<int, std::unordered_set<int>> &getParentsOfMethod() const;
-    const std::unordered_map<int, std::unordered_set<std::pair<int, OpType>, PairHash>> &getParentsOfAction() const;
+    const FlatMap<int, FlatSet<int>> &getParentsOfMethod() const;
+    const FlatMap<int, FlatSet<std::pair<int, OpType>>> &getParentsOfAction() const;
 
     const std::vector<int> &getFactVariables() const;
-    const std::unordered_map<int, int> &getMethodAndVariables() const;
-    const std::unordered_map<int, int> &getActionAndVariables() const;
+    const FlatMap<int, int> &getMethodAndVariables() const;
+    const FlatMap<int, int> &getActionAndVariables() const;
     const int getPrimVariable() const;
     const int getLeafOverleafVariable() const;
     const std::string getPositionString() const;
@@ -138,19 +132,27 @@ public:
     const int getTsSolution() const { return _ts_solution; }
     const std::pair<int, OpType> &getOpSolution() const;
 
-    void assignSatVariables(const HtnInstance &htn, const bool print_var_names, const bool is_po);
+    void assignSatVariables(const HtnInstance &htn, const bool print_var_names, const bool is_po, const bool alias_facts = false, const bool use_method_effects = false);
+    // Number of fact variables tied to the ones of the previous node (see assignFactVariables)
+    int getNumAliasedFactVariables() const { return _num_aliased_fact_variables; }
+    bool isFactAliased(int pred_id) const { return !_aliased_facts.empty() && _aliased_facts[pred_id]; }
 
     size_t computeNumberOfChildren(HtnInstance &htn);
     void expand(HtnInstance &htn);
     void expandPOWithBefore(HtnInstance &htn);
     void createChildren(HtnInstance &htn);
+    // Undo the expansion of this node. The ordering constraints towards deeper nodes must
+    // first be removed from all the nodes of the layer with forgetDeeperNodes, and the
+    // children themselves are released with their layer by PdtNodeArena::releaseLayer.
+    void forgetDeeperNodes();
+    void discardChildren();
     void addNodeThatMustBeExecutedBefore(PdtNode *node);
     void addNodeThatMustBeExecutedAfter(PdtNode *node);
-    const std::unordered_set<PdtNode *> &getNodeThatMustBeExecutedBefore() const
+    const PdtNodeSet &getNodeThatMustBeExecutedBefore() const
     {
         return _node_that_must_be_executed_before;
     }
-    const std::unordered_set<PdtNode *> &getNodeThatMustBeExecutedAfter() const
+    const PdtNodeSet &getNodeThatMustBeExecutedAfter() const
     {
         return _node_that_must_be_executed_after;
     }
@@ -170,7 +172,12 @@ public:
         return _layer;
     }
 
-    const std::unordered_set<PdtNode *> collectLeafChildren();
+    int getId() const
+    {
+        return _id;
+    }
+
+    void collectLeafChildren(std::vector<PdtNode *> &leaf_children);
     const std::string &getName() const
     {
         return _name;
@@ -188,17 +195,17 @@ public:
         return t >= getBaseTimeStep() && t < getEndTimeStep(numTs);
     }
 
-    const std::unordered_map<PdtNode *, OrderingConstrains> &getPossibleNextNodes() const
+    const PdtNodeMap<OrderingConstrains> &getPossibleNextNodes() const
     {
         return _possible_next_nodes;
     }
 
-    const std::unordered_map<PdtNode *, OrderingConstrains> &getPossiblePreviousNodes() const
+    const PdtNodeMap<OrderingConstrains> &getPossiblePreviousNodes() const
     {
         return _possible_previous_nodes;
     }
 
-    const std::unordered_map<PdtNode *, int> &getPossibleNextNodeVariable() const
+    const PdtNodeMap<int> &getPossibleNextNodeVariable() const
     {
         return _possible_next_node_variable;
     }
@@ -218,11 +225,6 @@ public:
         return _parent_method_idx_to_subtask_idx.at(parent_method_idx);
     }
 
-    void addBeforeNextNodeVar(PdtNode *next_node, int var)
-    {
-        _before_vars[next_node] = var;
-    }
-
     bool canBeFirstChild() const
     {
         return _can_be_first_child;
@@ -233,16 +235,23 @@ public:
         return _can_be_last_child;
     }
 
-    int getBeforeNextNodeVar(const PdtNode *next_node) const
-    {
-        if (_before_vars.find(next_node) == _before_vars.end())
-        {
-            return -1;
-        }
-        return _before_vars.at(next_node);
-    }
-
     void makeOrderingNoSibling();
+
+    // Predicates which may be changed (or only made true) between this node and its next node. Without the
+    // effects of the methods, all the predicates may be changed by a non primitive node.
+    std::vector<bool> computePredicatesChangedByOps(const HtnInstance &htn, const bool use_method_effects, const bool only_added = false) const;
+
+private:
+    // With fact aliasing (PO only), the facts of a node with a unique possible previous node are marked as aliased
+    // for all the predicates that the ops of this previous node cannot change: as it is always the predecessor
+    // of the node, the frame axioms between both nodes reduce to an equality, which the encoding adds instead.
+    // The equality only holds while the leaf overleaf of the layer is false, so the variables are not shared.
+    void assignFactVariables(const HtnInstance &htn, const bool print_var_names, const bool alias_facts, const bool use_method_effects);
 };
 
+inline bool PdtNodeLess::operator()(const PdtNode *a, const PdtNode *b) const
+{
+    return a->getId() < b->getId();
+}
+
 #endif // PDT_NODE_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "data/pdt_node_arena.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+
+PdtNodeArena::~PdtNodeArena()
+{
+    releaseLayer(0);
+}
+
+PdtNode *PdtNodeArena::create(const PdtNode *parent)
+{
+    size_t layer = parent == nullptr ? 0 : parent->getLayerIdx() + 1;
+    if (_blocks_per_layer.size() <= layer)
+        _blocks_per_layer.resize(layer + 1);
+
+    std::vector<Block> &blocks = _blocks_per_layer[layer];
+    if (blocks.empty() || blocks.back().size == blocks.back().capacity)
+    {
+        // Each new block of the layer is twice as large as the previous one
+        size_t capacity = blocks.empty() ? FIRST_BLOCK_CAPACITY : std::min(2 * blocks.back().capacity, MAX_BLOCK_CAPACITY);
+        blocks.push_back({std::allocator<PdtNode>().allocate(capacity), capacity, 0});
+    }
+
+    Block &block = blocks.back();
+    PdtNode *node = new (block.nodes + block.size) PdtNode(this, parent, _next_id++);
+    block.size++;
+    return node;
+}
+
+void PdtNodeArena::releaseBlock(Block &block)
+{
+    std::destroy_n(block.nodes, block.size);
+    std::allocator<PdtNode>().deallocate(block.nodes, block.capacity);
+}
+
+void PdtNodeArena::releaseLayer(int layer)
+{
+    for (size_t l = layer; l < _blocks_per_layer.size(); l++)
+    {
+        for (Block &block : _blocks_per_layer[l])
+            releaseBlock(block);
+    }
+    if ((size_t)layer < _blocks_per_layer.size())
+        _blocks_per_layer.resize(layer);
+}
+
+size_t PdtNodeArena::getNumNodes() const
+{
+    size_t num_nodes = 0;
+    for (const std::vector<Block> &blocks : _blocks_per_layer)
+    {
+        for (const Block &block : blocks)
+            num_nodes += block.size;
+    }
+    return num_nodes;
+}
@@ -0,0 +1,47 @@
+#ifndef PDT_NODE_ARENA_H
+#define PDT_NODE_ARENA_H
+
+#include <vector>
+
+#include "data/pdt_node.h"
+
+/**
+ * Owner of all the nodes of the tree. The nodes of each layer are allocated in contiguous
+ * blocks, so that the nodes of a layer are close in memory when the encoding iterates over
+ * them, and the whole tree is released block by block instead of with one delete per node.
+ */
+class PdtNodeArena
+{
+private:
+    struct Block
+    {
+        PdtNode *nodes;
+        size_t capacity;
+        size_t size;
+    };
+
+    static constexpr size_t FIRST_BLOCK_CAPACITY = 64;
+    static constexpr size_t MAX_BLOCK_CAPACITY = 8192;
+
+    std::vector<std::vector<Block>> _blocks_per_layer;
+    int _next_id = 0;
+
+    void releaseBlock(Block &block);
+
+public:
+    PdtNodeArena() = default;
+    PdtNodeArena(const PdtNodeArena &) = delete;
+    PdtNodeArena &operator=(const PdtNodeArena &) = delete;
+    ~PdtNodeArena();
+
+    // Create a new node (the root if parent is nullptr) in the block of its layer.
+    // The node is not added to the children of its parent.
+    PdtNode *create(const PdtNode *parent);
+
+    // Destroy all the nodes of the layer and of the deeper layers
+    void releaseLayer(int layer);
+
+    size_t getNumNodes() const;
+};
+
+#endif // PDT_NODE_ARENA_H
@@ -19,6 +19,11 @@ public:
     {
         return _name;
     }
+
+    bool isPositive() const
+    {
+        return _positive;
+    }
 };
 
 #endif // PREDICATE_H
\ No newline at end of file
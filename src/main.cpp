@@ -17,8 +17,10 @@
 #include "util/signal_manager.h"
 #include "util/statistics.h"
 #include "util/stacktrace.h" // Include the stacktrace utility
+#include "util/project_utils.h"
 #include "data/htn_instance.h"
 #include "algo/planner.h"
+#include "algo/planner_server.h"
 #include "util/dag_compressor.h"
 
 #ifndef TREEREX_VERSION
@@ -109,10 +111,8 @@ int main(int argc, char** argv) {
 
     Timer::init();
 
-    // TO TEST 
-    compressed_dag_test();
-    // END TEST
-
+    // Parameters::init modifies the arguments: the server forwards the original ones to its workers
+    std::vector<std::string> args(argv, argv + argc);
     Parameters params;
     params.init(argc, argv);
 
@@ -133,11 +133,24 @@ int main(int argc, char** argv) {
         exit(0);
     }
 
+    if (params.isNonzero("dagTest")) {
+        compressed_dag_test();
+    }
+
+    if (params.getParam("server") != "") {
+        PlannerServer server(params, args);
+        return server.run();
+    }
+
     if (params.getProblemFilename() == "") {
         Log::w("Please specify both a domain file and a problem file. Use -h for help.\n");
         exit(1);
     }
 
+    // Intermediate files of this run only
+    initProblemProcessingDir(params.getParam("workdir"), params.isNonzero("keepWorkdir"));
+    Log::d("Scratch directory: %s\n", getProblemProcessingDir().c_str());
+
     // Removed the try...catch block. Let uncaught exceptions trigger std::terminate.
     run(params);
 
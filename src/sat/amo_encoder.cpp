@@ -0,0 +1,301 @@
+#include "sat/amo_encoder.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include "sat/bimander_amo.h"
+#include "sat/variable_provider.h"
+#include "util/log.h"
+
+// Below this size, the pairwise encoding is both the smallest and the strongest one
+const size_t PAIRWISE_MAX_VARS = 6;
+const size_t COMMANDER_DEFAULT_GROUP_SIZE = 3;
+// Size of the AMO constraints above which the ops use the bimander encoding instead of the commander one
+const size_t OPS_COMMANDER_MAX_VARS = 64;
+
+AmoEncoder::AmoEncoder(Parameters &params)
+{
+    _default_strategy = parseStrategy(params.getParam("amo"));
+    auto roleStrategy = [&](const std::string &name)
+    {
+        std::string value = params.getParam(name);
+        return value == "amo" ? _default_strategy : parseStrategy(value);
+    };
+    _next_nodes_strategy = roleStrategy("amoNext");
+    _ops_strategy = roleStrategy("amoOps");
+    _mutex_strategy = roleStrategy("amoMutex");
+    _group_size = std::max(0, params.getIntParam("amoGroupSize"));
+}
+
+AmoStrategy AmoEncoder::selectStrategy(size_t num_vars, AmoRole role) const
+{
+    AmoStrategy strategy;
+    switch (role)
+    {
+    case AmoRole::NEXT_NODES:
+        strategy = _next_nodes_strategy;
+        break;
+    case AmoRole::HIERARCHY:
+    case AmoRole::ALL_OPS:
+        strategy = _ops_strategy;
+        break;
+    case AmoRole::MUTEX:
+        strategy = _mutex_strategy;
+        break;
+    }
+    if (strategy != AmoStrategy::AUTO)
+        return strategy;
+
+    if (num_vars <= PAIRWISE_MAX_VARS)
+        return AmoStrategy::PAIRWISE;
+    switch (role)
+    {
+    case AmoRole::NEXT_NODES:
+    case AmoRole::MUTEX:
+        // Repeated for each node: the sequential counter is linear and propagates as well as pairwise
+        return AmoStrategy::SEQUENTIAL;
+    case AmoRole::HIERARCHY:
+    case AmoRole::ALL_OPS:
+    default:
+        // Decision variables of the solver: keep direct binary exclusions inside small groups
+        return num_vars <= OPS_COMMANDER_MAX_VARS ? AmoStrategy::COMMANDER : AmoStrategy::BIMANDER;
+    }
+}
+
+void AmoEncoder::encode(const std::vector<int> &vars, AmoRole role, ClauseSink &sink) const
+{
+    encode(vars, selectStrategy(vars.size(), role), _group_size, sink);
+}
+
+void AmoEncoder::encode(const std::vector<int> &vars, AmoStrategy strategy, size_t group_size, ClauseSink &sink)
+{
+    if (vars.size() <= 1)
+        return;
+
+    switch (strategy)
+    {
+    case AmoStrategy::LEGACY:
+        if (vars.size() < 100)
+            encodePairwise(vars, 0, vars.size(), sink);
+        else
+            encodeBimander(vars, 0, sink);
+        break;
+    case AmoStrategy::AUTO:
+        // Without a role, only the size is known
+        encode(vars, vars.size() <= PAIRWISE_MAX_VARS ? AmoStrategy::PAIRWISE : AmoStrategy::SEQUENTIAL, group_size, sink);
+        break;
+    case AmoStrategy::PAIRWISE:
+        encodePairwise(vars, 0, vars.size(), sink);
+        break;
+    case AmoStrategy::SEQUENTIAL:
+        encodeSequential(vars, sink);
+        break;
+    case AmoStrategy::LADDER:
+        encodeLadder(vars, sink);
+        break;
+    case AmoStrategy::COMMANDER:
+        encodeCommander(vars, group_size, sink);
+        break;
+    case AmoStrategy::PRODUCT:
+        encodeProduct(vars, sink);
+        break;
+    case AmoStrategy::BINARY:
+        encodeBinary(vars, sink);
+        break;
+    case AmoStrategy::BIMANDER:
+        encodeBimander(vars, group_size, sink);
+        break;
+    }
+}
+
+int AmoEncoder::newAuxiliaryVariable(ClauseSink &sink)
+{
+    int var = VariableProvider::nextVar();
+    sink.addAuxiliaryVariable(var);
+    return var;
+}
+
+void AmoEncoder::encodePairwise(const std::vector<int> &vars, size_t begin, size_t end, ClauseSink &sink)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        for (size_t j = i + 1; j < end; j++)
+        {
+            sink.addClause(-vars[i], -vars[j]);
+        }
+    }
+}
+
+void AmoEncoder::encodeSequential(const std::vector<int> &vars, ClauseSink &sink)
+{
+    // s_i: one of the variables x_0..x_i is true
+    size_t n = vars.size();
+    std::vector<int> s(n - 1);
+    for (size_t i = 0; i < n - 1; i++)
+        s[i] = newAuxiliaryVariable(sink);
+
+    sink.addClause(-vars[0], s[0]);
+    for (size_t i = 1; i < n - 1; i++)
+    {
+        sink.addClause(-vars[i], s[i]);
+        sink.addClause(-s[i - 1], s[i]);
+        sink.addClause(-vars[i], -s[i - 1]);
+    }
+    sink.addClause(-vars[n - 1], -s[n - 2]);
+}
+
+void AmoEncoder::encodeLadder(const std::vector<int> &vars, ClauseSink &sink)
+{
+    // y_i: the true variable (if any) is after x_i. The ladder y_0 >= y_1 >= ... cuts the
+    // variables in two, and a true x_i must be exactly at the cut.
+    size_t n = vars.size();
+    std::vector<int> y(n - 1);
+    for (size_t i = 0; i < n - 1; i++)
+        y[i] = newAuxiliaryVariable(sink);
+
+    for (size_t i = 0; i + 1 < n - 1; i++)
+        sink.addClause(-y[i + 1], y[i]);
+    sink.addClause(-vars[0], -y[0]);
+    for (size_t i = 1; i < n - 1; i++)
+    {
+        sink.addClause(-vars[i], y[i - 1]);
+        sink.addClause(-vars[i], -y[i]);
+    }
+    sink.addClause(-vars[n - 1], y[n - 2]);
+}
+
+void AmoEncoder::encodeCommander(const std::vector<int> &vars, size_t group_size, ClauseSink &sink)
+{
+    if (group_size < 2)
+        group_size = COMMANDER_DEFAULT_GROUP_SIZE;
+    if (vars.size() <= std::max(group_size, PAIRWISE_MAX_VARS))
+    {
+        encodePairwise(vars, 0, vars.size(), sink);
+        return;
+    }
+
+    std::vector<int> commanders;
+    commanders.reserve((vars.size() + group_size - 1) / group_size);
+    for (size_t start = 0; start < vars.size(); start += group_size)
+    {
+        size_t end = std::min(start + group_size, vars.size());
+        encodePairwise(vars, start, end, sink);
+
+        // The commander is true iff a variable of its group is true
+        int commander = newAuxiliaryVariable(sink);
+        for (size_t i = start; i < end; i++)
+        {
+            sink.addClause(-vars[i], commander);
+        }
+        sink.appendClause(-commander);
+        for (size_t i = start; i < end; i++)
+        {
+            sink.appendClause(vars[i]);
+        }
+        sink.endClause();
+        commanders.push_back(commander);
+    }
+    encodeCommander(commanders, group_size, sink);
+}
+
+void AmoEncoder::encodeProduct(const std::vector<int> &vars, ClauseSink &sink)
+{
+    if (vars.size() <= PAIRWISE_MAX_VARS)
+    {
+        encodePairwise(vars, 0, vars.size(), sink);
+        return;
+    }
+
+    // Variables placed on a grid of num_rows x num_cols: at most one row and one column can be used
+    size_t num_rows = std::ceil(std::sqrt((double)vars.size()));
+    size_t num_cols = (vars.size() + num_rows - 1) / num_rows;
+    std::vector<int> rows(num_rows);
+    std::vector<int> cols(num_cols);
+    for (size_t i = 0; i < num_rows; i++)
+        rows[i] = newAuxiliaryVariable(sink);
+    for (size_t j = 0; j < num_cols; j++)
+        cols[j] = newAuxiliaryVariable(sink);
+
+    for (size_t k = 0; k < vars.size(); k++)
+    {
+        sink.addClause(-vars[k], rows[k / num_cols]);
+        sink.addClause(-vars[k], cols[k % num_cols]);
+    }
+    encodeProduct(rows, sink);
+    encodeProduct(cols, sink);
+}
+
+void AmoEncoder::encodeBinary(const std::vector<int> &vars, ClauseSink &sink)
+{
+    // Each true variable forces the bits to its index
+    size_t num_bits = std::ceil(std::log2((double)vars.size()));
+    std::vector<int> bits(num_bits);
+    for (size_t j = 0; j < num_bits; j++)
+        bits[j] = newAuxiliaryVariable(sink);
+
+    for (size_t i = 0; i < vars.size(); i++)
+    {
+        for (size_t j = 0; j < num_bits; j++)
+        {
+            bool bit = (i >> j) & 1;
+            sink.addClause(-vars[i], bit ? bits[j] : -bits[j]);
+        }
+    }
+}
+
+void AmoEncoder::encodeBimander(const std::vector<int> &vars, size_t group_size, ClauseSink &sink)
+{
+    size_t num_subsets = group_size == 0 ? (size_t)std::sqrt(vars.size()) : (vars.size() + group_size - 1) / group_size;
+    BimanderAtMostOne(vars, vars.size(), std::max((size_t)1, num_subsets)).encode(sink);
+}
+
+AmoStrategy AmoEncoder::parseStrategy(const std::string &name)
+{
+    for (AmoStrategy strategy : {AmoStrategy::LEGACY, AmoStrategy::AUTO})
+    {
+        if (name == toString(strategy))
+            return strategy;
+    }
+    for (AmoStrategy strategy : getExplicitStrategies())
+    {
+        if (name == toString(strategy))
+            return strategy;
+    }
+    Log::e("Unknown AMO strategy '%s'\n", name.c_str());
+    exit(1);
+}
+
+const char *AmoEncoder::toString(AmoStrategy strategy)
+{
+    switch (strategy)
+    {
+    case AmoStrategy::LEGACY:
+        return "legacy";
+    case AmoStrategy::AUTO:
+        return "auto";
+    case AmoStrategy::PAIRWISE:
+        return "pairwise";
+    case AmoStrategy::SEQUENTIAL:
+        return "sequential";
+    case AmoStrategy::LADDER:
+        return "ladder";
+    case AmoStrategy::COMMANDER:
+        return "commander";
+    case AmoStrategy::PRODUCT:
+        return "product";
+    case AmoStrategy::BINARY:
+        return "binary";
+    case AmoStrategy::BIMANDER:
+        return "bimander";
+    default:
+        return "unknown";
+    }
+}
+
+const std::vector<AmoStrategy> &AmoEncoder::getExplicitStrategies()
+{
+    static const std::vector<AmoStrategy> strategies = {
+        AmoStrategy::PAIRWISE, AmoStrategy::SEQUENTIAL, AmoStrategy::LADDER, AmoStrategy::COMMANDER,
+        AmoStrategy::PRODUCT, AmoStrategy::BINARY, AmoStrategy::BIMANDER};
+    return strategies;
+}
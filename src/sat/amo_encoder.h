@@ -0,0 +1,75 @@
+#ifndef AMO_ENCODER_H
+#define AMO_ENCODER_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include "util/params.h"
+#include "sat/clause_sink.h"
+
+enum class AmoStrategy
+{
+    LEGACY,     // Pairwise below 100 variables, bimander with sqrt(n) groups above (historical behaviour)
+    AUTO,       // Chosen from the number of variables and the role of the constraint (see selectStrategy)
+    PAIRWISE,   // n(n-1)/2 binary clauses, no auxiliary variable
+    SEQUENTIAL, // Sequential counter (Sinz): 3n-4 clauses, n-1 auxiliary variables
+    LADDER,     // Ladder / order encoding: ~3n clauses, n-1 auxiliary variables
+    COMMANDER,  // Commander (Klieber & Kwon): pairwise groups, recursive AMO over one commander per group
+    PRODUCT,    // Product (Chen): 2n + o(n) clauses, ~2 sqrt(n) auxiliary variables
+    BINARY,     // Binary (Frisch): n log n clauses, log n auxiliary variables
+    BIMANDER,   // Bimander (Nguyen & Mai): pairwise groups, binary encoding of the group index
+};
+
+// What the variables of an at-most-one constraint stand for
+enum class AmoRole
+{
+    NEXT_NODES, // Ordering variables towards the possible next / previous nodes of a node
+    HIERARCHY,  // Children of an op of the parent node
+    ALL_OPS,    // All the ops of a node
+    MUTEX,      // Facts of a mutex group at a node
+};
+
+/**
+ * Family of at-most-one encodings behind a single interface. The auxiliary variables are taken
+ * from the VariableProvider. The strategy of each call is selected from the number of variables and
+ * the role of the constraint, unless it is fixed by the parameters:
+ * -amo=<strategy> for all the roles, -amoNext, -amoOps, -amoMutex for a single one, and
+ * -amoGroupSize for the group size of the commander and bimander encodings.
+ * The clauses are streamed into a ClauseSink, without being materialized.
+ */
+class AmoEncoder
+{
+private:
+    AmoStrategy _default_strategy;
+    AmoStrategy _next_nodes_strategy;
+    AmoStrategy _ops_strategy;
+    AmoStrategy _mutex_strategy;
+    size_t _group_size;
+
+public:
+    AmoEncoder(Parameters &params);
+
+    AmoStrategy selectStrategy(size_t num_vars, AmoRole role) const;
+    void encode(const std::vector<int> &vars, AmoRole role, ClauseSink &sink) const;
+
+    // Encode with a given strategy. A group size of 0 lets the strategy choose it.
+    static void encode(const std::vector<int> &vars, AmoStrategy strategy, size_t group_size, ClauseSink &sink);
+
+    static AmoStrategy parseStrategy(const std::string &name);
+    static const char *toString(AmoStrategy strategy);
+    static const std::vector<AmoStrategy> &getExplicitStrategies();
+
+private:
+    static int newAuxiliaryVariable(ClauseSink &sink);
+    // Pairwise AMO over vars[begin, end)
+    static void encodePairwise(const std::vector<int> &vars, size_t begin, size_t end, ClauseSink &sink);
+    static void encodeSequential(const std::vector<int> &vars, ClauseSink &sink);
+    static void encodeLadder(const std::vector<int> &vars, ClauseSink &sink);
+    static void encodeCommander(const std::vector<int> &vars, size_t group_size, ClauseSink &sink);
+    static void encodeProduct(const std::vector<int> &vars, ClauseSink &sink);
+    static void encodeBinary(const std::vector<int> &vars, ClauseSink &sink);
+    static void encodeBimander(const std::vector<int> &vars, size_t group_size, ClauseSink &sink);
+};
+
+#endif // AMO_ENCODER_H
@@ -0,0 +1,60 @@
+#include "sat/before_variables.h"
+
+#include <cassert>
+#include "sat/variable_provider.h"
+#include "util/log.h"
+
+BeforeVariables::BeforeVariables(const std::vector<PdtNode *> &leaf_nodes, int layer, bool print_var_names)
+    : _layer(layer), _print_var_names(print_var_names)
+{
+    size_t num_nodes = leaf_nodes.size();
+    if (num_nodes > 1)
+        _lits.resize(getIndex(0, num_nodes), 0);
+
+    // The order of some pairs is already known from the hierarchy
+    for (const PdtNode *node : leaf_nodes)
+    {
+        int pos = node->getPos();
+        for (const PdtNode *next_node : node->getNodeThatMustBeExecutedAfter())
+        {
+            if (!isInLayer(next_node))
+                continue;
+            int next_pos = next_node->getPos();
+            if (pos < next_pos)
+                _lits[getIndex(pos, next_pos)] = TRUE_LIT;
+            else
+                _lits[getIndex(next_pos, pos)] = FALSE_LIT;
+        }
+    }
+}
+
+int BeforeVariables::getLiteral(const PdtNode *node_a, const PdtNode *node_b)
+{
+    assert(isInLayer(node_a) && isInLayer(node_b) && node_a != node_b);
+    int pos_a = node_a->getPos();
+    int pos_b = node_b->getPos();
+    bool flip = pos_a > pos_b;
+    int &lit = flip ? _lits[getIndex(pos_b, pos_a)] : _lits[getIndex(pos_a, pos_b)];
+    if (lit == 0)
+    {
+        lit = VariableProvider::nextVar();
+        if (_print_var_names)
+        {
+            const PdtNode *first = flip ? node_b : node_a;
+            const PdtNode *second = flip ? node_a : node_b;
+            std::string var_name = "layer_" + std::to_string(_layer) + "__node_" + first->getName() + "__before__node_" + second->getName();
+            Log::i("PVN: %d %s\n", lit, var_name.c_str());
+        }
+    }
+    return flip ? -lit : lit;
+}
+
+int BeforeVariables::peekLiteral(const PdtNode *node_a, const PdtNode *node_b) const
+{
+    assert(isInLayer(node_a) && isInLayer(node_b) && node_a != node_b);
+    int pos_a = node_a->getPos();
+    int pos_b = node_b->getPos();
+    if (pos_a > pos_b)
+        return -_lits[getIndex(pos_b, pos_a)];
+    return _lits[getIndex(pos_a, pos_b)];
+}
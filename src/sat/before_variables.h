@@ -0,0 +1,54 @@
+#ifndef BEFORE_VARIABLES_H
+#define BEFORE_VARIABLES_H
+
+#include <vector>
+#include <climits>
+
+#include "data/pdt_node.h"
+
+/**
+ * "Before" literals of all the pairs of leaf nodes of a layer, indexed by the position of the
+ * nodes in the layer and stored in a dense triangular array.
+ * Pairs whose order is already fixed by the hierarchy (_node_that_must_be_executed_before/_after)
+ * are constants, and a variable is only created for the other pairs when it is first requested,
+ * so that pairs which never appear in a clause do not cost any variable.
+ */
+class BeforeVariables
+{
+public:
+    // Literals of the pairs whose order is fixed
+    static constexpr int TRUE_LIT = INT_MAX;
+    static constexpr int FALSE_LIT = -INT_MAX;
+
+private:
+    const int _layer;
+    const bool _print_var_names;
+
+    // For a pair (i, j) with i < j: literal "i before j" (0 if no variable has been created yet)
+    std::vector<int> _lits;
+
+    size_t getIndex(int i, int j) const
+    {
+        return (size_t)j * (j - 1) / 2 + i;
+    }
+
+public:
+    BeforeVariables(const std::vector<PdtNode *> &leaf_nodes, int layer, bool print_var_names);
+
+    // Literal indicating that node_a is executed before node_b (a variable is created if needed)
+    int getLiteral(const PdtNode *node_a, const PdtNode *node_b);
+    // Same without creating any variable: returns 0 if no variable exists yet for this pair
+    int peekLiteral(const PdtNode *node_a, const PdtNode *node_b) const;
+
+    bool isInLayer(const PdtNode *node) const
+    {
+        return node->getLayerIdx() == _layer;
+    }
+
+    static bool isConstant(int lit)
+    {
+        return lit == TRUE_LIT || lit == FALSE_LIT;
+    }
+};
+
+#endif // BEFORE_VARIABLES_H
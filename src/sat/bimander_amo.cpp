@@ -7,7 +7,7 @@
 #include "util/log.h"
 
 BimanderAtMostOne::BimanderAtMostOne(const std::vector<int>& states, size_t numStates, size_t numSubsets)
-    : _states(states.begin(), states.begin() + numStates), _num_states(numStates), _num_subsets(numSubsets) {
+    : _states(states), _num_states(numStates), _num_subsets(numSubsets) {
 
     // Set up helper variables for a binary number representation
     _num_repr_states = 1;
@@ -19,10 +19,13 @@ BimanderAtMostOne::BimanderAtMostOne(const std::vector<int>& states, size_t numS
         _num_repr_states *= 2;
     }
 }
-std::vector<std::vector<int>> BimanderAtMostOne::encode() {
-    std::vector<std::vector<int>> cls;
+void BimanderAtMostOne::encode(ClauseSink &sink) const {
 
-    if (_num_states <= 1) return cls;
+    if (_num_states <= 1) return;
+
+    for (int var : _bin_num_vars) {
+        sink.addAuxiliaryVariable(var);
+    }
 
     // Divide states into subsets
     size_t groupSize = std::ceil(double(_num_states) / _num_subsets);
@@ -31,7 +34,7 @@ std::vector<std::vector<int>> BimanderAtMostOne::encode() {
         size_t end = std::min((i + 1) * groupSize, _num_states);
         for (size_t j = start; j < end; ++j) {
             for (size_t k = j + 1; k < end; ++k) {
-                cls.push_back({-_states[j], -_states[k]});
+                sink.addClause(-_states[j], -_states[k]);
             }
         }
     }
@@ -63,12 +66,10 @@ std::vector<std::vector<int>> BimanderAtMostOne::encode() {
             
                 bool bit = (i & (1 << j)) != 0;
                 int auxVar = bit ? _bin_num_vars[j] : -_bin_num_vars[j];
-                cls.push_back({-auxVar, -_states[h]});
+                sink.addClause(-auxVar, -_states[h]);
             }
         }
     }
-
-    return cls;
 }
 
 std::vector<int> BimanderAtMostOne::getClause(int state, bool sign) const {
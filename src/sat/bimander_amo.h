@@ -5,11 +5,13 @@
 #include <vector>
 #include <cstddef>
 
+#include "sat/clause_sink.h"
+
 class BimanderAtMostOne {
 
 private:
 
-    std::vector<int> _states;
+    const std::vector<int> &_states;
     size_t _num_states;
     std::vector<int> _bin_num_vars;
     size_t _num_repr_states;
@@ -17,7 +19,8 @@ private:
 
 public:
     BimanderAtMostOne(const std::vector<int>& states, size_t numStates, size_t sizeSubsets);
-    std::vector<std::vector<int>> encode();
+    // Stream the clauses into the sink
+    void encode(ClauseSink &sink) const;
 
 private:
     std::vector<int> getClause(int state, bool sign) const;
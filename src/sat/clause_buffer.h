@@ -0,0 +1,109 @@
+#ifndef CLAUSE_BUFFER_H
+#define CLAUSE_BUFFER_H
+
+#include <vector>
+#include <assert.h>
+
+/**
+ * Clauses stored contiguously, each one terminated by a 0 as in the IPASIR interface.
+ * The encoding writes its clauses into such a buffer, which is then given to the solver(s) in bulk.
+ */
+class ClauseBuffer
+{
+private:
+    std::vector<int> _lits;
+    // Index of the first literal of the clause being written
+    size_t _clause_start = 0;
+    int _num_cls = 0;
+    // Variables which must not be decision variables of the solver
+    std::vector<int> _no_decision_vars;
+
+public:
+    inline void add(int lit)
+    {
+        assert(lit != 0);
+        _lits.push_back(lit);
+    }
+
+    // Terminate the current clause and return its number of literals
+    inline int endClause()
+    {
+        int num_lits = _lits.size() - _clause_start;
+        _lits.push_back(0);
+        _clause_start = _lits.size();
+        _num_cls++;
+        return num_lits;
+    }
+
+    // Append all the (terminated) clauses of another buffer
+    void append(const ClauseBuffer &other)
+    {
+        assert(_clause_start == _lits.size() && other._clause_start == other._lits.size());
+        _lits.insert(_lits.end(), other._lits.begin(), other._lits.end());
+        _clause_start = _lits.size();
+        _num_cls += other._num_cls;
+        _no_decision_vars.insert(_no_decision_vars.end(), other._no_decision_vars.begin(), other._no_decision_vars.end());
+    }
+
+    // Same, but the variables greater or equal to min_var are shifted by offset
+    void append(const ClauseBuffer &other, int min_var, int offset)
+    {
+        assert(_clause_start == _lits.size() && other._clause_start == other._lits.size());
+        _lits.reserve(_lits.size() + other._lits.size());
+        for (int lit : other._lits)
+        {
+            if (lit >= min_var)
+                lit += offset;
+            else if (-lit >= min_var)
+                lit -= offset;
+            _lits.push_back(lit);
+        }
+        _clause_start = _lits.size();
+        _num_cls += other._num_cls;
+        for (int var : other._no_decision_vars)
+        {
+            _no_decision_vars.push_back(var >= min_var ? var + offset : var);
+        }
+    }
+
+    void addNoDecisionVariable(int var)
+    {
+        _no_decision_vars.push_back(var);
+    }
+
+    const std::vector<int> &getNoDecisionVariables() const
+    {
+        return _no_decision_vars;
+    }
+
+    // Literals of all the clauses, including the terminating zeros
+    const std::vector<int> &getLiterals() const
+    {
+        return _lits;
+    }
+
+    int getNumClauses() const
+    {
+        return _num_cls;
+    }
+
+    size_t getNumLiterals() const
+    {
+        return _lits.size() - _num_cls;
+    }
+
+    bool empty() const
+    {
+        return _lits.empty() && _no_decision_vars.empty();
+    }
+
+    void clear()
+    {
+        _lits.clear();
+        _no_decision_vars.clear();
+        _clause_start = 0;
+        _num_cls = 0;
+    }
+};
+
+#endif // CLAUSE_BUFFER_H
@@ -0,0 +1,20 @@
+#ifndef CLAUSE_SINK_H
+#define CLAUSE_SINK_H
+
+// Receives clauses one at a time, so that an encoding can stream them to their destination
+// (solver interface, buffer, counter...) without materializing them
+class ClauseSink
+{
+public:
+    virtual ~ClauseSink() = default;
+
+    virtual void addClause(int lit1, int lit2) = 0;
+    // Add a literal to the current clause
+    virtual void appendClause(int lit) = 0;
+    // Terminate the current clause
+    virtual void endClause() = 0;
+    // Auxiliary variable created by the encoding, whose value is defined by the clauses
+    virtual void addAuxiliaryVariable(int /*var*/) {}
+};
+
+#endif // CLAUSE_SINK_H
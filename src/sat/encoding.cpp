@@ -1,6 +1,6 @@
 #include "sat/encoding.h"
 #include "util/names.h"
-#include "sat/bimander_amo.h"
+#include "sat/before_variables.h"
 
 #include <cmath>
 
@@ -78,6 +78,12 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
     _stats.beginTiming(TimingStage::ENCODING_BEFORE);
     _stats.begin(STAGE_BEFORE_CLAUSES);
 
+    // Before literals of the pairs of nodes of this layer (variables are created on demand)
+    size_t layer = leaf_nodes[0]->getLayerIdx();
+    if (_before_variables.size() <= layer)
+        _before_variables.resize(layer + 1);
+    _before_variables[layer] = std::make_unique<BeforeVariables>(leaf_nodes, layer, _print_var_names);
+
     // --- Encode Ordering Constraints (Next AMO, Next=>Before, Transitivity, Hard Precedence) ---
     for (int i = 0; i < num_nodes; ++i)
     {
@@ -98,7 +104,7 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
         }
         if (prev_node_to_current_node_vars.size() > 1)
         {
-            encodeAtMostOne(prev_node_to_current_node_vars);
+            encodeAtMostOne(prev_node_to_current_node_vars, AmoRole::NEXT_NODES);
         }
         _stats.end(STAGE_BEFORE_PREDECESSORS);
 
@@ -115,18 +121,21 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
 
             // --- Encode next => before ---
             // int node_i_before_node_k_var = getBeforeLiteral(pos_i, pos_k);
-            int node_i_before_node_k_var = node_i->getBeforeNextNodeVar(next_node);
-            _sat.addClause(-next_node_i_node_k_var, node_i_before_node_k_var);
+            int node_i_before_node_k_var = getBeforeLiteral(node_i, next_node);
+            addClauseWithBeforeLiterals({-next_node_i_node_k_var, node_i_before_node_k_var});
 
             PdtNode *node_k = leaf_nodes[pos_k];
             if (node_k->getPossibleNextNodes().find(node_i) != node_k->getPossibleNextNodes().end())
             {
                 int next_node_k__node_i_var = node_k->getPossibleNextNodeVariable().at(node_i);
                 // If i is before k, then k cannot be a next node of i
-                _sat.addClause(-node_i_before_node_k_var, -next_node_k__node_i_var);
+                addClauseWithBeforeLiterals({-node_i_before_node_k_var, -next_node_k__node_i_var});
             }
 
             // --- Encode Transitivity ---
+            // In lazy mode, only the clauses violated by a model are added after solving
+            if (_lazy_transitivity)
+                continue;
             _stats.begin(STAGE_BEFORE_TRANSITIVITY);
             // for (const auto &[node_a, ordering] : next_node->getPossibleNextNodes()) {
             // For all other nodes 'a' (pos_a != pos_i)
@@ -151,24 +160,22 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
 
                 // int node_a_before_node_i_var = getBeforeLiteral(pos_a, pos_i);
                 // int node_a_before_node_k_var = getBeforeLiteral(pos_a, pos_k);
-                int node_a_before_node_i_var = node_a->getBeforeNextNodeVar(node_i);
-                int node_a_before_node_k_var = node_a->getBeforeNextNodeVar(next_node);
-
-                if (node_a_before_node_i_var == -1 || node_a_before_node_k_var == -1)
+                if (peekBeforeLiteral(node_a, node_i) == BeforeVariables::FALSE_LIT || peekBeforeLiteral(node_a, next_node) == BeforeVariables::FALSE_LIT)
                 {
-                    Log::i("Skip...\n");
-                    continue; // Skip if the before variable is not defined
+                    continue; // Skip if a cannot be before i or k
                 }
+                int node_a_before_node_i_var = getBeforeLiteral(node_a, node_i);
+                int node_a_before_node_k_var = getBeforeLiteral(node_a, next_node);
 
                 // (a before i) AND next(i, k) => (a before k)
                 // _sat.addClause(-node_a_before_node_i_var, -next_node_i_node_k_var, node_a_before_node_k_var);
                 // (not a before i) AND next(i, k) => (not a before k)
-                _sat.addClause(node_a_before_node_i_var, -next_node_i_node_k_var, -node_a_before_node_k_var);
+                addClauseWithBeforeLiterals({node_a_before_node_i_var, -next_node_i_node_k_var, -node_a_before_node_k_var});
 
                 // Not sure if it is useful
                 // int node_i_before_node_k_var = getBeforeLiteral(pos_i, pos_k);
                 // (a before i) AND (i before k) => (a before k)
-                _sat.addClause(-node_a_before_node_i_var, -node_i_before_node_k_var, node_a_before_node_k_var);
+                addClauseWithBeforeLiterals({-node_a_before_node_i_var, -node_i_before_node_k_var, node_a_before_node_k_var});
                 // (not a before i) AND (i before k) => (not a before k)
                 // _sat.addClause(node_a_before_node_i_var, node_i_before_node_k_var, -node_a_before_node_k_var);
             }
@@ -181,27 +188,17 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
         }
         if (current_node_to_next_node_vars.size() > 1)
         {
-            encodeAtMostOne(current_node_to_next_node_vars);
+            encodeAtMostOne(current_node_to_next_node_vars, AmoRole::NEXT_NODES);
         }
         _stats.end(STAGE_BEFORE_SUCCESSORS);
 
-        // --- Encode Hard Precedence ---
-        for (PdtNode *prev_node : node_i->getNodeThatMustBeExecutedBefore())
-        {
-            int pos_prev = prev_node->getPos();
-            // int before_lit = getBeforeLiteral(pos_prev, pos_i);
-            int before_lit = prev_node->getBeforeNextNodeVar(node_i);
-            _sat.addClause(before_lit); // Must be true
-        }
-        for (PdtNode *next_node : node_i->getNodeThatMustBeExecutedAfter())
-        {
-            int pos_next = next_node->getPos();
-            // int before_lit = getBeforeLiteral(pos_i, pos_next);
-            int before_lit = node_i->getBeforeNextNodeVar(next_node);
-            _sat.addClause(before_lit); // Must be true
-        }
+        // --- Hard Precedence ---
+        // Nothing to encode: the before literals of these pairs are constants
     }
 
+    if (_lazy_transitivity)
+        _lazy_transitivity_layers.push_back(leaf_nodes);
+
     Log::i("Finished encoding 'before' constraints.\n");
 
     // Finally, create a new var for leaf overleafs, that will be used for the FA
@@ -244,25 +241,20 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
                 for (const PdtNode *next_node_first_child : next_node_first_children)
                 {
                     // Get the before variable for the first child of parent and the first child of next_node
-                    int before_var = first_child->getBeforeNextNodeVar(next_node_first_child);
-                    if (before_var != -1)
+                    if (peekBeforeLiteral(first_child, next_node_first_child) != BeforeVariables::FALSE_LIT)
                     {
-                        before_vars.push_back(before_var);
+                        before_vars.push_back(getBeforeLiteral(first_child, next_node_first_child));
                     }
                 }
             }
 
-            int next_node_vars_2 = parent->getBeforeNextNodeVar(next_node);
+            int next_node_vars_2 = getBeforeLiteral(parent, next_node);
 
             // If the next node is true, then one of the before variables must be true
             if (before_vars.size() > 0)
             {
-                _sat.appendClause(-next_node_vars_2);
-                for (int before_var : before_vars)
-                {
-                    _sat.appendClause(before_var);
-                }
-                _sat.endClause();
+                before_vars.push_back(-next_node_vars_2);
+                addClauseWithBeforeLiterals(before_vars);
             }
         }
     }
@@ -278,19 +270,19 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
         {
             std::vector<const PdtNode *> &next_node_children = children_map[next_node];
 
-            int next_node_vars_2 = parent->getBeforeNextNodeVar(next_node);
+            int next_node_vars_2 = getBeforeLiteral(parent, next_node);
 
             for (const PdtNode *child : children)
             {
                 for (const PdtNode *next_node_child : next_node_children)
                 {
                     // Get the before variable for the first child of parent and the first child of next_node
-                    int before_var = child->getBeforeNextNodeVar(next_node_child);
-                    if (before_var != -1)
+                    if (peekBeforeLiteral(child, next_node_child) != BeforeVariables::FALSE_LIT)
                     {
+                        int before_var = getBeforeLiteral(child, next_node_child);
                         // If the next node is true, then one of the before variables must be true
                         // Encode the clause: next_node_var AND no_leaf_overleaf => before_vars
-                        _sat.addClause(-next_node_vars_2, parent_overleaf_var, before_var);
+                        addClauseWithBeforeLiterals({-next_node_vars_2, parent_overleaf_var, before_var});
                     }
                 }
             }
@@ -308,9 +300,24 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
     Log::i("Encoding mutexes...\n");
     if (_encode_mutexes)
     {
+        // Predicates which may be made true by the ops of each node
+        PdtNodeMap<std::vector<bool>> predicates_added_by_node;
+        if (_relevant_mutexes)
+        {
+            for (PdtNode *node : leaf_nodes)
+            {
+                predicates_added_by_node[node] = node->computePredicatesChangedByOps(_htn, _encode_prec_and_effs_methods, true);
+            }
+        }
+
         // Encode mutexes for all time steps
         for (int t = 0; t < num_nodes; ++t)
         {
+            if (_relevant_mutexes)
+            {
+                encodeRelevantMutexes(leaf_nodes[t], predicates_added_by_node);
+                continue;
+            }
             const std::vector<int> &current_fact_vars = leaf_nodes[t]->getFactVariables();
             // ENcode all groups
             for (const std::vector<int> &group : _htn.getMutex().getMutexGroups())
@@ -324,7 +331,7 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
                     group_vars.push_back(var);
                 }
                 // Encode the at-most-one constraint for this group
-                encodeAtMostOne(group_vars);
+                encodeAtMostOne(group_vars, AmoRole::MUTEX);
             }
         }
     }
@@ -344,204 +351,310 @@ void Encoding::encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes)
     _leaf_overleaf_vars.push_back(leaf_overleaf_var);
 
 
-    for (int i = 0; i < leaf_nodes.size(); ++i)
+    if (_encoding_pool == nullptr)
     {
-        // Log::i("Encode node %d/%d: %s\n", i, leaf_nodes.size(), TOSTR(*leaf_nodes[i]));
-        PdtNode *node = leaf_nodes[i];
-        const PdtNode *parent_node = node->getParent();
-        // int leaf_overleaf_var = node->getLeafOverleafVariable();
+        for (int i = 0; i < leaf_nodes.size(); ++i)
+        {
+            encodeLeafNodePO(leaf_nodes[i], leaf_overleaf_var);
+        }
+    }
+    else
+    {
+        encodeLeafNodesPOInParallel(leaf_nodes, leaf_overleaf_var);
+    }
 
-        // action implies prim, method implies not prim
-        _stats.begin(STAGE_PRIMITIVENESS);
-        encodePrimitivenessOps(node->getActionAndVariables(), node->getMethodAndVariables(), node->getPrimVariable());
-        _stats.end(STAGE_PRIMITIVENESS);
+    _layer_idx++;
+}
 
-        // Encode the hierarchy of each ops
-        _stats.beginTiming(TimingStage::ENCODING_HIERARCHY);
-        _stats.begin(STAGE_EXPANSIONS);
-        encodeHierarchy(node, parent_node);
-        _stats.endTiming(TimingStage::ENCODING_HIERARCHY);
-        _stats.end(STAGE_EXPANSIONS);
+void Encoding::encodeLeafNodePO(PdtNode *node, int leaf_overleaf_var)
+{
+    const PdtNode *parent_node = node->getParent();
+    // int leaf_overleaf_var = node->getLeafOverleafVariable();
+
+    // action implies prim, method implies not prim
+    _stats.begin(STAGE_PRIMITIVENESS);
+    encodePrimitivenessOps(node->getActionAndVariables(), node->getMethodAndVariables(), node->getPrimVariable());
+    _stats.end(STAGE_PRIMITIVENESS);
+
+    // Encode the hierarchy of each ops
+    _stats.beginTiming(TimingStage::ENCODING_HIERARCHY);
+    _stats.begin(STAGE_EXPANSIONS);
+    encodeHierarchy(node, parent_node);
+    _stats.endTiming(TimingStage::ENCODING_HIERARCHY);
+    _stats.end(STAGE_EXPANSIONS);
+
+    std::unordered_map<int, std::unordered_set<int>> positive_effs_can_be_implied_by;
+    std::unordered_map<int, std::unordered_set<int>> negative_effs_can_be_implied_by;
+
+    const std::vector<int> &current_fact_vars = node->getFactVariables();
+
+    // Encode actions preconditions
+    _stats.beginTiming(TimingStage::ENCODING_PREC);
+    _stats.begin(STAGE_PREC);
+    for (const auto &[action_idx, action_var] : node->getActionAndVariables())
+    {
+        const Action &action = _htn.getActionById(action_idx);
+        for (int precondition_idx : action.getPreconditionsIdx())
+        {
+            // Action && _ts_to_leaf_node[t][j] => precondition
+            // in CNF:
+            // (not action_var or not _ts_to_leaf_node[t][j] or current_fact_vars[precondition_idx])
+            _sat.addClause(-action_var, current_fact_vars[precondition_idx]);
+            // _sat.addClause(-action_var, leaf_overleaf_var, current_fact_vars[precondition_idx]);
+        }
+    }
 
-        std::unordered_map<int, std::unordered_set<int>> positive_effs_can_be_implied_by;
-        std::unordered_map<int, std::unordered_set<int>> negative_effs_can_be_implied_by;
+    if (_encode_prec_and_effs_methods)
+    {
+        // Encode methods preconditions
+        for (const auto &[method_idx, method_var] : node->getMethodAndVariables())
+        {
+            const Method &method = _htn.getMethodById(method_idx);
+            for (int precondition_idx : method.getPreconditionsIdx())
+            {
+                // Method && _ts_to_leaf_node[t][j] => precondition
+                // in CNF:
+                // (not method_var or not _ts_to_leaf_node[t][j] or current_fact_vars[precondition_idx])
+                // _sat.addClause(-method_var, current_fact_vars[precondition_idx]);
+                _sat.addClause(-method_var, leaf_overleaf_var, current_fact_vars[precondition_idx]); 
+                // _sat.addClause(-method_var, leaf_overleaf_var, current_fact_vars[precondition_idx]);
+            }
+        }
+    }
+    _stats.endTiming(TimingStage::ENCODING_PREC);
+    _stats.end(STAGE_PREC);
 
-        const std::vector<int> &current_fact_vars = node->getFactVariables();
+    _stats.beginTiming(TimingStage::ENCODING_EFF);
+    _stats.begin(STAGE_EFF);
+    
 
-        // Encode actions preconditions
-        _stats.beginTiming(TimingStage::ENCODING_PREC);
-        _stats.begin(STAGE_PREC);
+    // Encode actions for each possible next action var
+    for (const auto &[next_node, next_node_var] : node->getPossibleNextNodeVariable())
+    {
+        // Encode actions for each possible ts
+        const std::vector<int> &next_fact_vars = next_node->getFactVariables();
         for (const auto &[action_idx, action_var] : node->getActionAndVariables())
         {
             const Action &action = _htn.getActionById(action_idx);
-            for (int precondition_idx : action.getPreconditionsIdx())
+            for (int pos_effect_idx : action.getPosEffsIdx())
             {
-                // Action && _ts_to_leaf_node[t][j] => precondition
-                // in CNF:
-                // (not action_var or not _ts_to_leaf_node[t][j] or current_fact_vars[precondition_idx])
-                _sat.addClause(-action_var, current_fact_vars[precondition_idx]);
-                // _sat.addClause(-action_var, leaf_overleaf_var, current_fact_vars[precondition_idx]);
+                // _sat.addClause(-action_var, -next_node_var, next_fact_vars[pos_effect_idx]);
+                _sat.addClause(-action_var, -next_node_var, leaf_overleaf_var, next_fact_vars[pos_effect_idx]);
+            }
+            for (int neg_effect_idx : action.getNegEffsIdx())
+            {
+                // _sat.addClause(-action_var, -next_node_var, -next_fact_vars[neg_effect_idx]);
+                _sat.addClause(-action_var, -next_node_var, leaf_overleaf_var, -next_fact_vars[neg_effect_idx]);
             }
         }
 
         if (_encode_prec_and_effs_methods)
         {
-            // Encode methods preconditions
+            // Encode methods for each possible next action var
             for (const auto &[method_idx, method_var] : node->getMethodAndVariables())
             {
+                // Certified effects can only occurs if there is no leaf overleaf
                 const Method &method = _htn.getMethodById(method_idx);
-                for (int precondition_idx : method.getPreconditionsIdx())
+                for (int pos_effect_idx : method.getPosEffsIdx())
+                {
+                    // _sat.addClause(-method_var, -next_node_var, next_fact_vars[pos_effect_idx]);
+                    _sat.addClause(-method_var, -next_node_var, leaf_overleaf_var, next_fact_vars[pos_effect_idx]);
+                }
+                for (int neg_effect_idx : method.getNegEffsIdx())
                 {
-                    // Method && _ts_to_leaf_node[t][j] => precondition
-                    // in CNF:
-                    // (not method_var or not _ts_to_leaf_node[t][j] or current_fact_vars[precondition_idx])
-                    // _sat.addClause(-method_var, current_fact_vars[precondition_idx]);
-                    _sat.addClause(-method_var, leaf_overleaf_var, current_fact_vars[precondition_idx]); 
-                    // _sat.addClause(-method_var, leaf_overleaf_var, current_fact_vars[precondition_idx]);
+                    // _sat.addClause(-method_var, -next_node_var, -next_fact_vars[neg_effect_idx]);
+                    _sat.addClause(-method_var, -next_node_var, leaf_overleaf_var, -next_fact_vars[neg_effect_idx]);
                 }
             }
         }
-        _stats.endTiming(TimingStage::ENCODING_PREC);
-        _stats.end(STAGE_PREC);
+    }
+    _stats.endTiming(TimingStage::ENCODING_EFF);
+    _stats.end(STAGE_EFF);
 
-        _stats.beginTiming(TimingStage::ENCODING_EFF);
-        _stats.begin(STAGE_EFF);
-        
+    _stats.beginTiming(TimingStage::ENCODING_FIND_FA);
+    // Get the positive effects and negative effects of the actions
+    for (const auto &[action_idx, action_var] : node->getActionAndVariables())
+    {
+        const Action &action = _htn.getActionById(action_idx);
+        for (int pos_effect_idx : action.getPosEffsIdx())
+        {
+            positive_effs_can_be_implied_by[pos_effect_idx].insert(action_var);
+        }
+        for (int neg_effect_idx : action.getNegEffsIdx())
+        {
+            negative_effs_can_be_implied_by[neg_effect_idx].insert(action_var);
+        }
+    }
 
-        // Encode actions for each possible next action var
-        for (const auto &[next_node, next_node_var] : node->getPossibleNextNodeVariable())
+    if (_encode_prec_and_effs_methods)
+    {
+        // Get the positive effects and negative effects of the methods
+        for (const auto &[method_idx, method_var] : node->getMethodAndVariables())
         {
-            // Encode actions for each possible ts
-            const std::vector<int> &next_fact_vars = next_node->getFactVariables();
-            for (const auto &[action_idx, action_var] : node->getActionAndVariables())
+            const Method &method = _htn.getMethodById(method_idx);
+            for (int pos_effect_idx : method.getPossPosEffsIdx())
             {
-                const Action &action = _htn.getActionById(action_idx);
-                for (int pos_effect_idx : action.getPosEffsIdx())
-                {
-                    // _sat.addClause(-action_var, -next_node_var, next_fact_vars[pos_effect_idx]);
-                    _sat.addClause(-action_var, -next_node_var, leaf_overleaf_var, next_fact_vars[pos_effect_idx]);
-                }
-                for (int neg_effect_idx : action.getNegEffsIdx())
-                {
-                    // _sat.addClause(-action_var, -next_node_var, -next_fact_vars[neg_effect_idx]);
-                    _sat.addClause(-action_var, -next_node_var, leaf_overleaf_var, -next_fact_vars[neg_effect_idx]);
-                }
+                positive_effs_can_be_implied_by[pos_effect_idx].insert(method_var);
             }
-
-            if (_encode_prec_and_effs_methods)
+            for (int neg_effect_idx : method.getPossNegEffsIdx())
             {
-                // Encode methods for each possible next action var
-                for (const auto &[method_idx, method_var] : node->getMethodAndVariables())
-                {
-                    // Certified effects can only occurs if there is no leaf overleaf
-                    const Method &method = _htn.getMethodById(method_idx);
-                    for (int pos_effect_idx : method.getPosEffsIdx())
-                    {
-                        // _sat.addClause(-method_var, -next_node_var, next_fact_vars[pos_effect_idx]);
-                        _sat.addClause(-method_var, -next_node_var, leaf_overleaf_var, next_fact_vars[pos_effect_idx]);
-                    }
-                    for (int neg_effect_idx : method.getNegEffsIdx())
-                    {
-                        // _sat.addClause(-method_var, -next_node_var, -next_fact_vars[neg_effect_idx]);
-                        _sat.addClause(-method_var, -next_node_var, leaf_overleaf_var, -next_fact_vars[neg_effect_idx]);
-                    }
-                }
+                negative_effs_can_be_implied_by[neg_effect_idx].insert(method_var);
             }
         }
-        _stats.endTiming(TimingStage::ENCODING_EFF);
-        _stats.end(STAGE_EFF);
+    }
 
-        _stats.beginTiming(TimingStage::ENCODING_FIND_FA);
-        // Get the positive effects and negative effects of the actions
-        for (const auto &[action_idx, action_var] : node->getActionAndVariables())
+    _stats.endTiming(TimingStage::ENCODING_FIND_FA);
+
+    _stats.beginTiming(TimingStage::ENCODING_FA);
+    _stats.begin(STAGE_FRAMEAXIOMS);
+    // Encode frame axioms
+    // Encode frame axioms for each possible ts
+    const int &prim_var = node->getPrimVariable();
+    // With several possible next nodes, the ops supporting a change of a predicate are only listed once,
+    // in the definition of a support variable used by the frame axioms towards each next node
+    const bool use_support_vars = _effect_support_vars && node->getPossibleNextNodeVariable().size() > 1;
+    std::vector<int> pos_support_vars(use_support_vars ? _htn.getNumPredicates() : 0, 0);
+    std::vector<int> neg_support_vars(use_support_vars ? _htn.getNumPredicates() : 0, 0);
+    for (const auto &[next_node, next_node_var] : node->getPossibleNextNodeVariable())
+    {
+        const std::vector<int> &next_fact_vars = next_node->getFactVariables();
+        for (int i = 0; i < _htn.getNumPredicates(); i++)
         {
-            const Action &action = _htn.getActionById(action_idx);
-            for (int pos_effect_idx : action.getPosEffsIdx())
+            // Fact aliased to the one of this node (its unique previous node): both frame axioms reduce to
+            // an equality, unless there is a leaf overleaf
+            if (next_node->isFactAliased(i))
             {
-                positive_effs_can_be_implied_by[pos_effect_idx].insert(action_var);
+                _sat.addClause(leaf_overleaf_var, -current_fact_vars[i], next_fact_vars[i]);
+                _sat.addClause(leaf_overleaf_var, current_fact_vars[i], -next_fact_vars[i]);
+                continue;
             }
-            for (int neg_effect_idx : action.getNegEffsIdx())
+            int neg_support_var = 0;
+            int pos_support_var = 0;
+            if (use_support_vars)
             {
-                negative_effs_can_be_implied_by[neg_effect_idx].insert(action_var);
+                neg_support_var = getEffectSupportVariable(node, i, false, negative_effs_can_be_implied_by, neg_support_vars);
+                pos_support_var = getEffectSupportVariable(node, i, true, positive_effs_can_be_implied_by, pos_support_vars);
             }
-        }
-
-        if (_encode_prec_and_effs_methods)
-        {
-            // Get the positive effects and negative effects of the methods
-            for (const auto &[method_idx, method_var] : node->getMethodAndVariables())
+            // If this predicate was true and become false, then either there is a method responsable for this change (so the position is non primtiive)
+            // Or an action must be responsible for this change:
+            // pred__t and not pred__t+1 => (non prim or negative effect of an action)
+            // In CNF:
+            // (not pred__t or pred__t+1 or non_prim or action_1_with_negative_effect or action_2_with_negative_effect)
+            _sat.appendClause(-current_fact_vars[i], next_fact_vars[i]);
+            _sat.appendClause(-next_node_var); // Check only for this node at this ts
+
+            if (!_encode_prec_and_effs_methods)
             {
-                const Method &method = _htn.getMethodById(method_idx);
-                for (int pos_effect_idx : method.getPossPosEffsIdx())
+                _sat.appendClause(-prim_var);
+            }
+            // Is there a leaf overleaf ?
+            _sat.appendClause(leaf_overleaf_var);
+            if (neg_support_var != 0)
+            {
+                _sat.appendClause(neg_support_var);
+            }
+            else if (negative_effs_can_be_implied_by.find(i) != negative_effs_can_be_implied_by.end())
+            {
+                for (int action_var : negative_effs_can_be_implied_by.at(i))
                 {
-                    positive_effs_can_be_implied_by[pos_effect_idx].insert(method_var);
+                    _sat.appendClause(action_var);
                 }
-                for (int neg_effect_idx : method.getPossNegEffsIdx())
+            }
+            _sat.endClause();
+            // Do the same things if a predicate was false and become true
+            _sat.appendClause(current_fact_vars[i], -next_fact_vars[i]);
+            _sat.appendClause(-next_node_var); // Check only for this node at this ts
+
+            if (!_encode_prec_and_effs_methods)
+            {
+                _sat.appendClause(-prim_var);
+            }
+            // Is there a leaf overleaf ?
+            _sat.appendClause(leaf_overleaf_var);
+            if (pos_support_var != 0)
+            {
+                _sat.appendClause(pos_support_var);
+            }
+            else if (positive_effs_can_be_implied_by.find(i) != positive_effs_can_be_implied_by.end())
+            {
+                for (int action_var : positive_effs_can_be_implied_by.at(i))
                 {
-                    negative_effs_can_be_implied_by[neg_effect_idx].insert(method_var);
+                    _sat.appendClause(action_var);
                 }
             }
+            _sat.endClause();
         }
+    }
+    _stats.endTiming(TimingStage::ENCODING_FA);
+    _stats.end(STAGE_FRAMEAXIOMS);
+}
 
-        _stats.endTiming(TimingStage::ENCODING_FIND_FA);
+int Encoding::getEffectSupportVariable(const PdtNode *node, int pred_idx, bool positive, const std::unordered_map<int, std::unordered_set<int>> &effs_can_be_implied_by, std::vector<int> &support_vars)
+{
+    if (support_vars[pred_idx] != 0)
+    {
+        return support_vars[pred_idx];
+    }
+    // A single supporting op is as short as its support variable
+    auto it = effs_can_be_implied_by.find(pred_idx);
+    if (it == effs_can_be_implied_by.end() || it->second.size() < 2)
+    {
+        return 0;
+    }
 
-        _stats.beginTiming(TimingStage::ENCODING_FA);
-        _stats.begin(STAGE_FRAMEAXIOMS);
-        // Encode frame axioms
-        // Encode frame axioms for each possible ts
-        const int &prim_var = node->getPrimVariable();
-        for (const auto &[next_node, next_node_var] : node->getPossibleNextNodeVariable())
-        {
-            const std::vector<int> &next_fact_vars = next_node->getFactVariables();
-            for (int i = 0; i < _htn.getNumPredicates(); i++)
-            {
-                // If this predicate was true and become false, then either there is a method responsable for this change (so the position is non primtiive)
-                // Or an action must be responsible for this change:
-                // pred__t and not pred__t+1 => (non prim or negative effect of an action)
-                // In CNF:
-                // (not pred__t or pred__t+1 or non_prim or action_1_with_negative_effect or action_2_with_negative_effect)
-                _sat.appendClause(-current_fact_vars[i], next_fact_vars[i]);
-                _sat.appendClause(-next_node_var); // Check only for this node at this ts
-
-                if (!_encode_prec_and_effs_methods)
-                {
-                    _sat.appendClause(-prim_var);
-                }
-                // Is there a leaf overleaf ?
-                _sat.appendClause(leaf_overleaf_var);
-                if (negative_effs_can_be_implied_by.find(i) != negative_effs_can_be_implied_by.end())
-                {
-                    for (int action_var : negative_effs_can_be_implied_by.at(i))
-                    {
-                        _sat.appendClause(action_var);
-                    }
-                }
-                _sat.endClause();
-                // Do the same things if a predicate was false and become true
-                _sat.appendClause(current_fact_vars[i], -next_fact_vars[i]);
-                _sat.appendClause(-next_node_var); // Check only for this node at this ts
+    int support_var = VariableProvider::nextVar();
+    if (_print_var_names && !VariableProvider::isLocalVariable(support_var))
+    {
+        std::string var_name = std::string(positive ? "support_pos__" : "support_neg__") + _htn.getPredicateById(pred_idx).getName() + "__" + node->getName();
+        Log::i("PVN: %d %s\n", support_var, var_name.c_str());
+    }
+    // support => one of the ops which can make the change
+    _sat.appendClause(-support_var);
+    for (int op_var : it->second)
+    {
+        _sat.appendClause(op_var);
+    }
+    _sat.endClause();
+    support_vars[pred_idx] = support_var;
+    return support_var;
+}
 
-                if (!_encode_prec_and_effs_methods)
-                {
-                    _sat.appendClause(-prim_var);
-                }
-                // Is there a leaf overleaf ?
-                _sat.appendClause(leaf_overleaf_var);
-                if (positive_effs_can_be_implied_by.find(i) != positive_effs_can_be_implied_by.end())
-                {
-                    for (int action_var : positive_effs_can_be_implied_by.at(i))
-                    {
-                        _sat.appendClause(action_var);
-                    }
-                }
-                _sat.endClause();
-            }
+void Encoding::encodeLeafNodesPOInParallel(const std::vector<PdtNode *> &leaf_nodes, int leaf_overleaf_var)
+{
+    // The nodes are split into contiguous chunks (more chunks than threads to balance the load), each one
+    // encoded into its own buffer. The buffers are then added in the order of the chunks, and the local
+    // variables of each chunk are numbered as they are added: the formula is the same as the one of the
+    // sequential encoding, whatever the number of threads.
+    size_t num_chunks = std::min(leaf_nodes.size(), (size_t)_encoding_pool->getNumThreads() * 4);
+    std::vector<ClauseBuffer> chunk_clauses(num_chunks);
+    std::vector<int> chunk_num_local_vars(num_chunks);
+
+    _encoding_pool->parallelFor(num_chunks, [&](size_t chunk)
+                                {
+        size_t begin = leaf_nodes.size() * chunk / num_chunks;
+        size_t end = leaf_nodes.size() * (chunk + 1) / num_chunks;
+
+        // The calling thread also encodes chunks: restore its state afterwards
+        bool was_muted = Statistics::isThreadMuted();
+        Statistics::muteThread(true);
+        ClauseBuffer *previous_buffer = SatInterface::redirectThreadClauses(&chunk_clauses[chunk]);
+        VariableProvider::beginLocalVariables();
+        for (size_t i = begin; i < end; i++)
+        {
+            encodeLeafNodePO(leaf_nodes[i], leaf_overleaf_var);
         }
-        _stats.endTiming(TimingStage::ENCODING_FA);
-        _stats.end(STAGE_FRAMEAXIOMS);
-    }
+        chunk_num_local_vars[chunk] = VariableProvider::endLocalVariables();
+        SatInterface::redirectThreadClauses(previous_buffer);
+        Statistics::muteThread(was_muted); });
 
-    _layer_idx++;
+    _stats.begin(STAGE_PARALLEL_NODES);
+    for (size_t chunk = 0; chunk < num_chunks; chunk++)
+    {
+        int first_local_var = VariableProvider::nextVars(chunk_num_local_vars[chunk]);
+        _sat.addClauses(chunk_clauses[chunk], first_local_var);
+        chunk_clauses[chunk].clear();
+    }
+    _stats.end(STAGE_PARALLEL_NODES);
 }
 
 void Encoding::initalEncode(PdtNode *root_node)
@@ -589,7 +702,7 @@ void Encoding::encodeGoalState(const std::vector<int> &all_pred_vars, const std:
     }
 }
 
-void Encoding::encodeActions(const std::unordered_map<int, int> &map_action_idx_to_var, const std::vector<int> &current_fact_vars, const std::vector<int> &next_fact_vars, std::unordered_map<int, std::unordered_set<int>> &positive_effs_can_be_implied_by, std::unordered_map<int, std::unordered_set<int>> &negative_effs_can_be_implied_by)
+void Encoding::encodeActions(const FlatMap<int, int> &map_action_idx_to_var, const std::vector<int> &current_fact_vars, const std::vector<int> &next_fact_vars, std::unordered_map<int, std::unordered_set<int>> &positive_effs_can_be_implied_by, std::unordered_map<int, std::unordered_set<int>> &negative_effs_can_be_implied_by)
 {
     for (const auto &[action_idx, action_var] : map_action_idx_to_var)
     {
@@ -630,7 +743,7 @@ void Encoding::encodeActions(const std::unordered_map<int, int> &map_action_idx_
 //     }
 // }
 
-void Encoding::encodePrimitivenessOps(const std::unordered_map<int, int> &map_action_idx_to_var, const std::unordered_map<int, int> &map_method_idx_to_var, const int &prim_var)
+void Encoding::encodePrimitivenessOps(const FlatMap<int, int> &map_action_idx_to_var, const FlatMap<int, int> &map_method_idx_to_var, const int &prim_var)
 {
     for (const auto &[action_idx, action_var] : map_action_idx_to_var)
     {
@@ -675,24 +788,86 @@ void Encoding::encodeFrameAxioms(const std::vector<int> &current_fact_vars, cons
     }
 }
 
-void Encoding::encodeAtMostOne(const std::vector<int> &vars)
+void Encoding::encodeAtMostOne(const std::vector<int> &vars, AmoRole role)
 {
-    if (vars.size() < 100)
+    _amo_encoder.encode(vars, role, _sat);
+}
+
+void Encoding::encodeRelevantMutexes(const PdtNode *node, const PdtNodeMap<std::vector<bool>> &predicates_added_by_node)
+{
+    const std::vector<int> &fact_vars = node->getFactVariables();
+
+    // Predicates which may become true at this node (all of them for a node which may be the first one)
+    bool all_added = node->getPossiblePreviousNodes().empty();
+    std::vector<bool> added(_htn.getNumPredicates(), false);
+    for (const auto &[previous_node, ordering] : node->getPossiblePreviousNodes())
     {
-        for (int i = 0; i < vars.size(); i++)
+        auto it = predicates_added_by_node.find(previous_node);
+        if (it == predicates_added_by_node.end())
         {
-            for (int j = i + 1; j < vars.size(); j++)
-            {
-                _sat.addClause(-vars[i], -vars[j]);
-            }
+            all_added = true;
+            break;
+        }
+        for (int i = 0; i < _htn.getNumPredicates(); i++)
+        {
+            if (it->second[i])
+                added[i] = true;
         }
     }
-    else
+
+    std::vector<int> group_vars;
+    std::vector<int> added_vars;
+    std::vector<int> held_vars;
+    for (const std::vector<int> &group : _htn.getMutex().getMutexGroups())
     {
-        size_t size_amo = vars.size();
-        auto bamo = BimanderAtMostOne(vars, size_amo, (size_t)std::sqrt(size_amo));
-        for (const auto &c : bamo.encode())
-            _sat.addClause(c);
+        group_vars.clear();
+        added_vars.clear();
+        held_vars.clear();
+        for (int pred_idx : group)
+        {
+            group_vars.push_back(fact_vars[pred_idx]);
+            if (all_added || added[pred_idx])
+                added_vars.push_back(fact_vars[pred_idx]);
+            else
+                held_vars.push_back(fact_vars[pred_idx]);
+        }
+
+        // The group holds at the previous node, and a true member here was already true there:
+        // two members can only be true together if one of them was just added
+        if (added_vars.empty())
+        {
+            continue;
+        }
+        if (held_vars.empty())
+        {
+            encodeAtMostOne(group_vars, AmoRole::MUTEX);
+            continue;
+        }
+        size_t num_added = added_vars.size();
+        size_t num_held = held_vars.size();
+        if ((num_added - 1) * num_held <= num_added)
+        {
+            // Few pairs between added and held members: exclude them directly
+            encodeAtMostOne(added_vars, AmoRole::MUTEX);
+            for (int added_var : added_vars)
+            {
+                for (int held_var : held_vars)
+                {
+                    _sat.addClause(-added_var, -held_var);
+                }
+            }
+        }
+        else
+        {
+            // One variable stands for all the held members
+            int held_var = VariableProvider::nextVar();
+            for (int var : held_vars)
+            {
+                _sat.addClause(-var, held_var);
+            }
+            added_vars.push_back(held_var);
+            encodeAtMostOne(added_vars, AmoRole::MUTEX);
+        }
     }
 }
 
@@ -777,7 +952,7 @@ void Encoding::encodeHierarchy(const PdtNode *cur_node, const PdtNode *parent_no
         _sat.endClause();
 
         if (encode_at_most_one_on_children_instead_of_all_ops) {
-            encodeAtMostOne(children);
+            encodeAtMostOne(children, AmoRole::HIERARCHY);
         }
     }
     _stats.endTiming(TimingStage::TEST_1);
@@ -794,11 +969,81 @@ void Encoding::encodeHierarchy(const PdtNode *cur_node, const PdtNode *parent_no
         {
             all_ops.push_back(op_var);
         }
-        encodeAtMostOne(all_ops);
+        encodeAtMostOne(all_ops, AmoRole::ALL_OPS);
     }
     _stats.endTiming(TimingStage::TEST_5);
 }
 
+void Encoding::beginSpeculativeLayer()
+{
+    _saved_num_ts = _num_ts;
+    _saved_layer_idx = _layer_idx;
+    _saved_num_leaf_overleaf_vars = _leaf_overleaf_vars.size();
+    _saved_num_lazy_transitivity_layers = _lazy_transitivity_layers.size();
+    _saved_num_before_variables = _before_variables.size();
+    _speculative_layer_pending = true;
+    _counters_before_speculation = _stats.getClauseCounters();
+    _sat.beginBuffering();
+}
+
+void Encoding::endSpeculativeLayer()
+{
+    _sat.endBuffering();
+    _counters_after_speculation = _stats.getClauseCounters();
+}
+
+void Encoding::commitSpeculativeLayer()
+{
+    _sat.flushBuffer();
+    _speculative_layer_pending = false;
+}
+
+void Encoding::discardSpeculativeLayer()
+{
+    _sat.discardBuffer();
+    _stats.removeClauseCounters(_counters_before_speculation, _counters_after_speculation);
+    _num_ts = _saved_num_ts;
+    _layer_idx = _saved_layer_idx;
+    _leaf_overleaf_vars.resize(_saved_num_leaf_overleaf_vars);
+    _lazy_transitivity_layers.resize(_saved_num_lazy_transitivity_layers);
+    _before_variables.resize(_saved_num_before_variables);
+    _speculative_layer_pending = false;
+}
+
+void Encoding::restrictFactDecisions(const std::vector<PdtNode *> &leaf_nodes, bool is_po)
+{
+    // The facts of the previous layer may not be determined anymore: its leaf overleaf is not assumed false
+    _sat.releaseNoDecisionVariables(_no_decision_fact_vars);
+    _no_decision_fact_vars.clear();
+
+    for (size_t i = 0; i < leaf_nodes.size(); i++)
+    {
+        // The facts of a node are determined by the ones of its predecessor if this one executes an action
+        // (through its effects and the frame axioms), not if it may hold a method (possible effects)
+        bool determined;
+        if (is_po)
+        {
+            determined = !leaf_nodes[i]->getPossiblePreviousNodes().empty();
+            for (const auto &[previous_node, ordering] : leaf_nodes[i]->getPossiblePreviousNodes())
+            {
+                if (!previous_node->getMethodAndVariables().empty())
+                    determined = false;
+            }
+        }
+        else
+        {
+            determined = i > 0 && leaf_nodes[i - 1]->getMethodAndVariables().empty();
+        }
+        if (!determined)
+            continue;
+        for (int fact_var : leaf_nodes[i]->getFactVariables())
+        {
+            _sat.setNoDecision(fact_var);
+            _no_decision_fact_vars.push_back(fact_var);
+        }
+    }
+}
+
 void Encoding::addAssumptions(const std::vector<int> &assumptions)
 {
     for (int assumption : assumptions)
@@ -807,11 +1052,221 @@ void Encoding::addAssumptions(const std::vector<int> &assumptions)
     }
 }
 
+int Encoding::getBeforeLiteral(const PdtNode *node_a, const PdtNode *node_b)
+{
+    return _before_variables[node_a->getLayerIdx()]->getLiteral(node_a, node_b);
+}
+
+int Encoding::peekBeforeLiteral(const PdtNode *node_a, const PdtNode *node_b) const
+{
+    return _before_variables[node_a->getLayerIdx()]->peekLiteral(node_a, node_b);
+}
+
+void Encoding::addClauseWithBeforeLiterals(std::initializer_list<int> lits)
+{
+    for (int lit : lits)
+    {
+        if (lit == BeforeVariables::TRUE_LIT)
+            return; // Clause already satisfied
+    }
+    for (int lit : lits)
+    {
+        if (lit != BeforeVariables::FALSE_LIT)
+            _sat.appendClause(lit);
+    }
+    _sat.endClause();
+}
+
+void Encoding::addClauseWithBeforeLiterals(const std::vector<int> &lits)
+{
+    for (int lit : lits)
+    {
+        if (lit == BeforeVariables::TRUE_LIT)
+            return; // Clause already satisfied
+    }
+    for (int lit : lits)
+    {
+        if (lit != BeforeVariables::FALSE_LIT)
+            _sat.appendClause(lit);
+    }
+    _sat.endClause();
+}
+
 int Encoding::solve()
 {
+    if (_sat.getNumNoDecisionVariables() > 0)
+    {
+        Log::i("  %zu variables are not decision variables\n", _sat.getNumNoDecisionVariables());
+    }
     return _sat.solve();
 }
 
+void Encoding::repeatLastAssumptions()
+{
+    // Copy as assuming clears the last assumptions of the solver
+    std::vector<int> assumptions = _sat.getLastAssumptions();
+    addAssumptions(assumptions);
+}
+
+int Encoding::addViolatedTransitivityClauses()
+{
+    // Before literals without variable do not appear in the formula yet and are considered false
+    auto isTrue = [this](int lit)
+    {
+        if (BeforeVariables::isConstant(lit) || lit == 0)
+            return lit == BeforeVariables::TRUE_LIT;
+        return lit > 0 ? _sat.holds(lit) : !_sat.holds(-lit);
+    };
+
+    // The variables of a speculative layer are not in the solver yet
+    size_t num_layers = _speculative_layer_pending ? _saved_num_lazy_transitivity_layers : _lazy_transitivity_layers.size();
+
+    int num_added = 0;
+    _stats.begin(STAGE_BEFORE_TRANSITIVITY);
+    for (size_t layer = 0; layer < num_layers; layer++)
+    {
+        const std::vector<PdtNode *> &leaf_nodes = _lazy_transitivity_layers[layer];
+        for (PdtNode *node_i : leaf_nodes)
+        {
+            for (const auto &[next_node, next_node_i_node_k_var] : node_i->getPossibleNextNodeVariable())
+            {
+                int node_i_before_node_k_var = getBeforeLiteral(node_i, next_node);
+                bool next_i_k = _sat.holds(next_node_i_node_k_var);
+                bool i_before_k = isTrue(node_i_before_node_k_var);
+                // Both clauses are satisfied whatever the value of the other before variables
+                if (!next_i_k && !i_before_k)
+                    continue;
+
+                for (PdtNode *node_a : leaf_nodes)
+                {
+                    if (node_a == node_i || node_a == next_node)
+                        continue;
+                    // Same pairs as skipped by the complete encoding
+                    if (node_a->getNodeThatMustBeExecutedBefore().count(node_i) ||
+                        node_a->getNodeThatMustBeExecutedBefore().count(next_node))
+                        continue;
+                    int node_a_before_node_i_var = peekBeforeLiteral(node_a, node_i);
+                    int node_a_before_node_k_var = peekBeforeLiteral(node_a, next_node);
+                    if (node_a_before_node_i_var == BeforeVariables::FALSE_LIT || node_a_before_node_k_var == BeforeVariables::FALSE_LIT)
+                        continue;
+
+                    bool a_before_i = isTrue(node_a_before_node_i_var);
+                    bool a_before_k = isTrue(node_a_before_node_k_var);
+                    // (not a before i) AND next(i, k) => (not a before k)
+                    if (!a_before_i && next_i_k && a_before_k)
+                    {
+                        addClauseWithBeforeLiterals({getBeforeLiteral(node_a, node_i), -next_node_i_node_k_var, -getBeforeLiteral(node_a, next_node)});
+                        num_added++;
+                    }
+                    // (a before i) AND (i before k) => (a before k)
+                    if (a_before_i && i_before_k && !a_before_k)
+                    {
+                        addClauseWithBeforeLiterals({-getBeforeLiteral(node_a, node_i), -node_i_before_node_k_var, getBeforeLiteral(node_a, next_node)});
+                        num_added++;
+                    }
+                }
+            }
+        }
+    }
+    _stats.end(STAGE_BEFORE_TRANSITIVITY);
+
+    return num_added;
+}
+
+std::vector<int> Encoding::getPlanActionVariables(PdtNode *leaf_node)
+{
+    std::vector<int> vars;
+    for (const auto &[action_idx, action_var] : leaf_node->getActionAndVariables())
+    {
+        // Blank, init and goal actions
+        if (action_idx < 0)
+            continue;
+        const std::string &name = _htn.getActionById(action_idx).getName();
+        if (name == "__noop" || name.find("__method_precondition") != std::string::npos)
+            continue;
+        vars.push_back(action_var);
+    }
+    return vars;
+}
+
+int Encoding::countPlanActions(const std::vector<PdtNode *> &leaf_nodes)
+{
+    int num_actions = 0;
+    for (PdtNode *node : leaf_nodes)
+    {
+        for (int var : getPlanActionVariables(node))
+        {
+            if (_sat.holds(var))
+            {
+                num_actions++;
+                break;
+            }
+        }
+    }
+    return num_actions;
+}
+
+std::vector<int> Encoding::encodePlanLengthCounter(const std::vector<PdtNode *> &leaf_nodes, int max_count)
+{
+    _stats.begin(STAGE_PLANLENGTHCOUNTING);
+
+    // One variable per leaf node implied by its actions which count in the length of the plan
+    std::vector<int> counted_vars;
+    for (PdtNode *node : leaf_nodes)
+    {
+        std::vector<int> action_vars = getPlanActionVariables(node);
+        if (action_vars.size() == 1)
+        {
+            counted_vars.push_back(action_vars[0]);
+        }
+        else if (action_vars.size() > 1)
+        {
+            int counted_var = VariableProvider::nextVar();
+            for (int action_var : action_vars)
+            {
+                _sat.addClause(-action_var, counted_var);
+            }
+            counted_vars.push_back(counted_var);
+        }
+    }
+
+    // at_least[j-1]: at least j of the counted variables seen so far are true
+    std::vector<int> at_least(max_count);
+    for (size_t i = 0; i < counted_vars.size(); i++)
+    {
+        std::vector<int> next_at_least(max_count);
+        for (int j = 0; j < max_count; j++)
+        {
+            next_at_least[j] = VariableProvider::nextVar();
+            if (i > 0)
+            {
+                _sat.addClause(-at_least[j], next_at_least[j]);
+            }
+            if (j == 0)
+            {
+                _sat.addClause(-counted_vars[i], next_at_least[j]);
+            }
+            else if (i > 0)
+            {
+                _sat.addClause(-counted_vars[i], -at_least[j - 1], next_at_least[j]);
+            }
+        }
+        at_least = std::move(next_at_least);
+    }
+    if (counted_vars.empty())
+    {
+        // No action can be counted: all the bounds hold
+        for (int j = 0; j < max_count; j++)
+        {
+            at_least[j] = VariableProvider::nextVar();
+        }
+    }
+
+    _stats.end(STAGE_PLANLENGTHCOUNTING);
+    Log::i("Plan length counter over %zu leaf nodes up to %d actions\n", counted_vars.size(), max_count);
+    return at_least;
+}
+
 void Encoding::setOpsTrueInTree(PdtNode *node, bool is_po)
 {
     Log::i("For node %s\n", TOSTR(*node));
@@ -1,9 +1,14 @@
 #ifndef ENCODING_H
 #define ENCODING_H
 
+#include <memory>
+
 #include "data/htn_instance.h"
 #include "sat/sat_interface.h"
+#include "sat/before_variables.h"
+#include "sat/amo_encoder.h"
 #include "data/pdt_node.h"
+#include "util/thread_pool.h"
 
 class Encoding
 {
@@ -14,22 +19,70 @@ private:
 
     // For PO
     std::vector<int> _leaf_overleaf_vars;
-    int _num_ts;
+    int _num_ts = 0;
+    std::vector<std::unique_ptr<BeforeVariables>> _before_variables; // Indexed by layer
 
     const bool _encode_prec_and_effs_methods = _htn.getParams().isNonzero("sibylsat");
 
     int _layer_idx = 0;
 
+    // State saved before a speculative encoding of a layer (see beginSpeculativeLayer)
+    int _saved_num_ts;
+    int _saved_layer_idx;
+    size_t _saved_num_leaf_overleaf_vars;
+    size_t _saved_num_lazy_transitivity_layers;
+    size_t _saved_num_before_variables;
+    // Set between the beginning of a speculative layer and its commit / discard
+    bool _speculative_layer_pending = false;
+    Statistics::ClauseCounters _counters_before_speculation;
+    Statistics::ClauseCounters _counters_after_speculation;
+
+    // -decisionOpsOnly: facts of the last layer which are not decision variables (see restrictFactDecisions)
+    std::vector<int> _no_decision_fact_vars;
+
+    // Lazy transitivity: the transitivity clauses of the before variables are not encoded upfront,
+    // only the ones violated by a model are added (see addViolatedTransitivityClauses)
+    const bool _lazy_transitivity = _htn.getParams().isNonzero("lazyTransitivity");
+    std::vector<std::vector<PdtNode *>> _lazy_transitivity_layers;
+
     const bool _print_var_names = _htn.getParams().isNonzero("pvn");
     const bool _encode_mutexes = _htn.getParams().isNonzero("mutex");
+    const AmoEncoder _amo_encoder{_htn.getParams()};
+    // Only encode the part of the mutex groups which is not implied by the mutexes of the previous nodes
+    // and the frame axioms (only holds if the leaf overleaf of the layer is false)
+    const bool _relevant_mutexes = _htn.getParams().isNonzero("relevantMutexes");
+    // Compress the frame axioms of the nodes with several possible next nodes with effect support variables
+    const bool _effect_support_vars = _htn.getParams().isNonzero("effectSupportVars");
+
+    // Threads encoding the leaf nodes of a layer in parallel (none if a single thread is used)
+    const int _num_encoding_threads = _htn.getParams().getIntParam("encodingThreads");
+    std::unique_ptr<ThreadPool> _encoding_pool = _num_encoding_threads > 1 ? std::make_unique<ThreadPool>(_num_encoding_threads) : nullptr;
 
     void encodeInitialState(const std::vector<int> &all_pred_vars, const std::unordered_set<int> &init_state);
     void encodeGoalState(const std::vector<int> &all_pred_vars, const std::unordered_set<int> &goal_state);
-    void encodeActions(const std::unordered_map<int, int> &map_action_idx_to_var, const std::vector<int> &current_fact_vars, const std::vector<int> &next_fact_vars, std::unordered_map<int, std::unordered_set<int>> &positive_effs_can_be_implied_by, std::unordered_map<int, std::unordered_set<int>> &negative_effs_can_be_implied_by);
-    void encodePrimitivenessOps(const std::unordered_map<int, int> &map_action_idx_to_var, const std::unordered_map<int, int> &map_method_idx_to_var, const int &prim_var);
+    void encodeActions(const FlatMap<int, int> &map_action_idx_to_var, const std::vector<int> &current_fact_vars, const std::vector<int> &next_fact_vars, std::unordered_map<int, std::unordered_set<int>> &positive_effs_can_be_implied_by, std::unordered_map<int, std::unordered_set<int>> &negative_effs_can_be_implied_by);
+    // Variables of the actions of a leaf node which count in the length of the plan
+    std::vector<int> getPlanActionVariables(PdtNode *leaf_node);
+    void encodePrimitivenessOps(const FlatMap<int, int> &map_action_idx_to_var, const FlatMap<int, int> &map_method_idx_to_var, const int &prim_var);
     void encodeFrameAxioms(const std::vector<int> &current_fact_vars, const std::vector<int> &next_fact_vars, const int &prim_var, const std::unordered_map<int, std::unordered_set<int>> &positive_effs_can_be_implied_by, const std::unordered_map<int, std::unordered_set<int>> &negative_effs_can_be_implied_by);
-    void encodeAtMostOne(const std::vector<int> &vars);
+    void encodeAtMostOne(const std::vector<int> &vars, AmoRole role);
+    // Mutex groups of a node, only constraining the members which may become true at this node (see relevantMutexes)
+    void encodeRelevantMutexes(const PdtNode *node, const PdtNodeMap<std::vector<bool>> &predicates_added_by_node);
     void encodeHierarchy(const PdtNode *cur_node, const PdtNode *parentNode);
+    // Primitiveness, hierarchy, preconditions, effects and frame axioms of a leaf node (PO).
+    // Only reads the tree and the instance, so that several nodes can be encoded concurrently.
+    void encodeLeafNodePO(PdtNode *node, int leaf_overleaf_var);
+    void encodeLeafNodesPOInParallel(const std::vector<PdtNode *> &leaf_nodes, int leaf_overleaf_var);
+    // Variable which implies one of the ops of the node with the given effect on the predicate (created and
+    // defined on first use), or 0 if there are less than two such ops
+    int getEffectSupportVariable(const PdtNode *node, int pred_idx, bool positive, const std::unordered_map<int, std::unordered_set<int>> &effs_can_be_implied_by, std::vector<int> &support_vars);
+
+    // Before literal of two nodes of the same layer (may be a constant, see BeforeVariables)
+    int getBeforeLiteral(const PdtNode *node_a, const PdtNode *node_b);
+    int peekBeforeLiteral(const PdtNode *node_a, const PdtNode *node_b) const;
+    // Add a clause which may contain constant before literals
+    void addClauseWithBeforeLiterals(std::initializer_list<int> lits);
+    void addClauseWithBeforeLiterals(const std::vector<int> &lits);
 
 public:
     Encoding(HtnInstance &htn) : _htn(htn), _sat(htn.getParams()), _stats(Statistics::getInstance()) {}
@@ -38,6 +91,18 @@ public:
     void encode(std::vector<PdtNode *> &leaf_nodes);
     void encodePOWithBefore(std::vector<PdtNode *> &leaf_nodes);
 
+    // Speculative encoding of a layer (pipelined mode): the clauses of the layer are kept in
+    // a buffer until the previous layer is known to be UNSAT (commit) or SAT (discard).
+    // beginSpeculativeLayer and endSpeculativeLayer must be called by the thread encoding the layer.
+    void beginSpeculativeLayer();
+    void endSpeculativeLayer();
+    void commitSpeculativeLayer();
+    void discardSpeculativeLayer();
+
+    void traceComment(const std::string &comment)
+    {
+        _sat.traceComment(comment);
+    }
     void writeFormula(std::string filename)
     {
         _sat.print_formula(filename);
@@ -45,6 +110,23 @@ public:
 
     // Indicate for each node, which action or method is true
     void setOpsTrueInTree(PdtNode *node, bool is_po);
+    // Number of leaf nodes executing an action of the plan in the current model (blank, __noop and
+    // method precondition actions are not counted)
+    int countPlanActions(const std::vector<PdtNode *> &leaf_nodes);
+    // Sequential counter over the leaf nodes executing an action of the plan. Returns the variables
+    // r_1, ..., r_max_count where r_j is implied if at least j leaf nodes do: assuming -r_{k+1} allows at most k actions.
+    std::vector<int> encodePlanLengthCounter(const std::vector<PdtNode *> &leaf_nodes, int max_count);
+
+    // With -decisionOpsOnly, the facts of the layer to solve which are determined by propagation are not
+    // decision variables: the ones of the nodes whose possible previous nodes only hold actions, as long as
+    // the leaf overleaf of the layer is assumed false (PO). The facts of the previous layer become decision
+    // variables again. Must be called before the layer is solved, by the thread which solves it.
+    void restrictFactDecisions(const std::vector<PdtNode *> &leaf_nodes, bool is_po);
+    // For the solve calls which do not assume the leaf overleaf of the last layer false
+    void setDecisionsRestricted(bool restricted)
+    {
+        _sat.setDecisionsRestricted(restricted);
+    }
 
     void addAssumptions(const std::vector<int> &assumptions);
     void setPhase(int var, int phase)
@@ -59,11 +141,24 @@ public:
     {
         return _sat.holds(lit);
     }
+    void setTerminateCallback(void *state, int (*terminate)(void *state))
+    {
+        _sat.setTerminateCallback(state, terminate);
+    }
+    const std::vector<int> &getLastAssumptions() const
+    {
+        return _sat.getLastAssumptions();
+    }
     bool causeFail(int lit)
     {
         return _sat.didAssumptionFail(lit);
     }
     int solve();
+    // Add the assumptions of the last solve call again
+    void repeatLastAssumptions();
+    // Add the transitivity clauses violated by the current model (lazy transitivity).
+    // Returns the number of clauses added.
+    int addViolatedTransitivityClauses();
 
     int assignTsToLeafNode(PdtNode *leaf_node);
 };
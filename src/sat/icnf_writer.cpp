@@ -0,0 +1,110 @@
+#include "sat/icnf_writer.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "util/log.h"
+
+IcnfWriter::IcnfWriter(const std::string &filename, const std::string &compress_command) : _buffer(BUFFER_SIZE)
+{
+    if (compress_command.empty() || compress_command == "none")
+    {
+        _file = fopen(filename.c_str(), "wb");
+    }
+    else
+    {
+        std::string command = compress_command + " > '" + filename + "'";
+        _file = popen(command.c_str(), "w");
+        _is_pipe = true;
+    }
+    if (_file == nullptr)
+    {
+        Log::e("Cannot open the formula trace %s: %s\n", filename.c_str(), strerror(errno));
+        return;
+    }
+    Log::i("Writing the formula trace to %s%s\n", filename.c_str(), _is_pipe ? (" through \"" + compress_command + "\"").c_str() : "");
+
+    const char header[] = "p inccnf\n";
+    memcpy(_buffer.data(), header, sizeof(header) - 1);
+    _size = sizeof(header) - 1;
+}
+
+IcnfWriter::~IcnfWriter()
+{
+    close();
+}
+
+void IcnfWriter::writeClauses(const std::vector<int> &lits)
+{
+    if (_file == nullptr)
+        return;
+    for (int lit : lits)
+    {
+        reserve(MAX_LITERAL_SIZE);
+        if (lit == 0)
+        {
+            put('0');
+            put('\n');
+        }
+        else
+        {
+            putInt(lit);
+            put(' ');
+        }
+    }
+}
+
+void IcnfWriter::writeAssumptions(const std::vector<int> &assumptions)
+{
+    if (_file == nullptr)
+        return;
+    reserve(2);
+    put('a');
+    put(' ');
+    for (int lit : assumptions)
+    {
+        reserve(MAX_LITERAL_SIZE);
+        putInt(lit);
+        put(' ');
+    }
+    reserve(2);
+    put('0');
+    put('\n');
+}
+
+void IcnfWriter::writeComment(const std::string &comment)
+{
+    if (_file == nullptr)
+        return;
+    reserve(comment.size() + 3);
+    if (comment.size() + 3 > _buffer.size())
+        _buffer.resize(comment.size() + 3);
+    put('c');
+    put(' ');
+    memcpy(_buffer.data() + _size, comment.data(), comment.size());
+    _size += comment.size();
+    put('\n');
+}
+
+void IcnfWriter::flush()
+{
+    if (_file == nullptr || _size == 0)
+        return;
+    if (fwrite(_buffer.data(), 1, _size, _file) != _size)
+    {
+        Log::e("Error while writing the formula trace\n");
+    }
+    _size = 0;
+}
+
+void IcnfWriter::close()
+{
+    if (_file == nullptr)
+        return;
+    flush();
+    if (_is_pipe)
+        pclose(_file);
+    else
+        fclose(_file);
+    _file = nullptr;
+}
@@ -0,0 +1,80 @@
+#ifndef ICNF_WRITER_H
+#define ICNF_WRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Trace of an incremental SAT solving session in the iCNF format:
+ *   p inccnf
+ *   <clause> 0           (clauses added since the previous line)
+ *   a <assumptions> 0    (a solve call under these assumptions)
+ * The literals are formatted into a large buffer which is written in a single pass, either into the
+ * file or into the standard input of a command (e.g. "gzip -c" or "zstd -q") whose output is the file.
+ * See src/bench/icnf_replay.cpp to replay such a trace with an IPASIR solver.
+ */
+class IcnfWriter
+{
+private:
+    FILE *_file = nullptr;
+    bool _is_pipe = false;
+    std::vector<char> _buffer;
+    size_t _size = 0;
+
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    // Longest formatted literal: sign, 10 digits and a separator
+    static constexpr size_t MAX_LITERAL_SIZE = 12;
+
+public:
+    // compress_command: command reading the trace on its standard input and writing the compressed
+    // trace on its standard output ("none" to write the file directly)
+    IcnfWriter(const std::string &filename, const std::string &compress_command);
+    ~IcnfWriter();
+
+    IcnfWriter(const IcnfWriter &) = delete;
+    IcnfWriter &operator=(const IcnfWriter &) = delete;
+
+    bool isOpen() const
+    {
+        return _file != nullptr;
+    }
+
+    // Zero-terminated clauses, as in a ClauseBuffer
+    void writeClauses(const std::vector<int> &lits);
+    void writeAssumptions(const std::vector<int> &assumptions);
+    void writeComment(const std::string &comment);
+
+    void flush();
+    void close();
+
+private:
+    inline void reserve(size_t size)
+    {
+        if (_size + size > _buffer.size())
+            flush();
+    }
+
+    inline void put(char c)
+    {
+        _buffer[_size++] = c;
+    }
+
+    inline void putInt(int value)
+    {
+        char digits[MAX_LITERAL_SIZE];
+        int num_digits = 0;
+        unsigned int abs_value = value < 0 ? -(unsigned int)value : value;
+        if (value < 0)
+            put('-');
+        do
+        {
+            digits[num_digits++] = '0' + abs_value % 10;
+            abs_value /= 10;
+        } while (abs_value != 0);
+        while (num_digits > 0)
+            put(digits[--num_digits]);
+    }
+};
+
+#endif // ICNF_WRITER_H
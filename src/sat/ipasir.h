@@ -118,7 +118,12 @@ void ipasir_set_learn (void * solver, void * state, int max_length, void (*learn
  */
 void ipasir_set_seed (void * s, int seed);
 /**
- * Set a phase for the given variable.
+ * Make a fraction of the decisions of the solver on random variables, and
+ * initialize the activities of the variables randomly (from the seed).
+ */
+void ipasir_set_random_decisions (void * s, double frequency);
+/**
+ * Set the value tried first when the solver decides on the given variable.
  */
 void ipasir_set_phase (void * s, unsigned int v, bool phase);
 /**
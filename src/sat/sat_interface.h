@@ -8,176 +8,183 @@
 #include <iostream>
 #include <assert.h>
 #include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <unordered_set>
 
 #include "util/params.h"
 #include "util/log.h"
 #include "util/statistics.h"
 #include "sat/variable_provider.h"
+#include "sat/clause_buffer.h"
+#include "sat/clause_sink.h"
+#include "sat/icnf_writer.h"
+#include "util/project_utils.h"
 
 extern "C"
 {
 #include "sat/ipasir.h"
 }
 
-class SatInterface
+class SatInterface final : public ClauseSink
 {
 
 private:
     Parameters &_params;
-    void *_solver;
-    std::ofstream _out;
+    // File of the formula trace (-wf)
+    std::string _trace_path;
+    // Portfolio of independently seeded solvers which all receive the same clauses and assumptions.
+    // Without the portfolio option, it only contains a single solver.
+    std::vector<void *> _solvers;
+    // Index of the solver which answered the last solve call (its model / failed assumptions are used)
+    size_t _winner = 0;
+    // Set as soon as one solver of the portfolio has answered, so that the other ones get interrupted
+    std::atomic<bool> _race_finished{false};
+    // Terminate callback set by the user (forwarded by the portfolio callback)
+    void *_terminate_state = nullptr;
+    int (*_terminate)(void *state) = nullptr;
+    // Variables whose phase has already been diversified in the portfolio
+    int _num_diversified_vars = 0;
+    // Variables given a phase by setPhase (indexed by variable), left out of the diversification
+    std::vector<bool> _seeded_phases;
+    // Random phases of the solvers of the portfolio which use them (one generator per solver)
+    std::vector<std::minstd_rand> _phase_generators;
+    // Incremental trace of the formula and of the solve calls (-wf)
+    std::unique_ptr<IcnfWriter> _trace;
     Statistics &_stats;
 
     const bool _print_formula;
-    bool _began_line = false;
+    // Only the op and ordering variables are decision variables: the variables given to setNoDecision
+    // and the auxiliary variables of the encodings are not
+    const bool _restrict_decisions;
+    // Cleared while the restriction is lifted (see setDecisionsRestricted)
+    bool _decisions_restricted = true;
+
+    // Clauses not given to the solver(s) yet. They are flushed in bulk before solving
+    // (or earlier if the buffer becomes too large)
+    ClauseBuffer _pending;
+    static constexpr size_t MAX_PENDING_LITERALS = 1 << 22;
+    // Fraction of random decisions of the solvers of the portfolio (except the first one)
+    static constexpr double PORTFOLIO_RANDOM_DECISIONS = 0.01;
+    // Clauses kept aside by a buffering thread, until they are either flushed or discarded
+    ClauseBuffer _held;
+    // Buffer in which the clauses of the current thread are written instead of _pending (if any)
+    static inline thread_local ClauseBuffer *_thread_sink = nullptr;
 
     std::vector<int> _last_assumptions;
-    std::vector<int> _no_decision_variables;
+    std::unordered_set<int> _no_decision_variables;
     std::map<int, int> _soft_literals_to_weights;
 
 public:
-    SatInterface(Parameters &params) : _params(params), _stats(Statistics::getInstance()), _print_formula(params.isNonzero("wf"))
+    SatInterface(Parameters &params) : _params(params), _stats(Statistics::getInstance()), _print_formula(params.isNonzero("wf")), _restrict_decisions(params.isNonzero("decisionOpsOnly"))
     {
-
-        _solver = ipasir_init();
-        ipasir_set_seed(_solver, params.getIntParam("s"));
+        int num_solvers = std::max(1, params.getIntParam("portfolio"));
+        int seed = params.getIntParam("s");
+        for (int i = 0; i < num_solvers; i++)
+        {
+            void *solver = ipasir_init();
+            ipasir_set_seed(solver, seed + i);
+            // The seed alone does not change the search of the solver
+            if (i > 0)
+                ipasir_set_random_decisions(solver, PORTFOLIO_RANDOM_DECISIONS);
+            _solvers.push_back(solver);
+            _phase_generators.emplace_back(seed + i + 1);
+        }
+        if (num_solvers > 1)
+        {
+            Log::i("Using a portfolio of %i solvers\n", num_solvers);
+            for (void *solver : _solvers)
+                ipasir_set_terminate(solver, this, &SatInterface::terminatePortfolio);
+        }
         if (_print_formula)
-            _out.open("formula.cnf");
+        {
+            _trace_path = getRunOutputPath(params.getParam("wfFile"), "f.icnf");
+            _trace = std::make_unique<IcnfWriter>(_trace_path, params.getParam("wfCompress"));
+        }
     }
 
     inline void addClause(int lit)
     {
-        assert(lit != 0);
-        ipasir_add(_solver, lit);
-        ipasir_add(_solver, 0);
-        if (_print_formula)
-            _out << lit << " 0\n";
-        _stats._num_lits++;
-        _stats._num_cls++;
+        ClauseBuffer &buffer = sink();
+        buffer.add(lit);
+        buffer.endClause();
+        countClause(buffer, 1);
     }
-    inline void addClause(int lit1, int lit2)
+    inline void addClause(int lit1, int lit2) override
     {
-        assert(lit1 != 0);
-        assert(lit2 != 0);
-        ipasir_add(_solver, lit1);
-        ipasir_add(_solver, lit2);
-        ipasir_add(_solver, 0);
-        if (_print_formula)
-            _out << lit1 << " " << lit2 << " 0\n";
-        _stats._num_lits += 2;
-        _stats._num_cls++;
+        ClauseBuffer &buffer = sink();
+        buffer.add(lit1);
+        buffer.add(lit2);
+        buffer.endClause();
+        countClause(buffer, 2);
     }
     inline void addClause(int lit1, int lit2, int lit3)
     {
-        assert(lit1 != 0);
-        assert(lit2 != 0);
-        assert(lit3 != 0);
-        ipasir_add(_solver, lit1);
-        ipasir_add(_solver, lit2);
-        ipasir_add(_solver, lit3);
-        ipasir_add(_solver, 0);
-        if (_print_formula)
-            _out << lit1 << " " << lit2 << " " << lit3 << " 0\n";
-        _stats._num_lits += 3;
-        _stats._num_cls++;
+        ClauseBuffer &buffer = sink();
+        buffer.add(lit1);
+        buffer.add(lit2);
+        buffer.add(lit3);
+        buffer.endClause();
+        countClause(buffer, 3);
     }
     inline void addClause(int lit1, int lit2, int lit3, int lit4)
     {
-        assert(lit1 != 0);
-        assert(lit2 != 0);
-        assert(lit3 != 0);
-        assert(lit4 != 0);
-        ipasir_add(_solver, lit1);
-        ipasir_add(_solver, lit2);
-        ipasir_add(_solver, lit3);
-        ipasir_add(_solver, lit4);
-        ipasir_add(_solver, 0);
-        if (_print_formula)
-            _out << lit1 << " " << lit2 << " " << lit3 << " " << lit4 << " 0\n";
-        _stats._num_lits += 4;
-        _stats._num_cls++;
+        ClauseBuffer &buffer = sink();
+        buffer.add(lit1);
+        buffer.add(lit2);
+        buffer.add(lit3);
+        buffer.add(lit4);
+        buffer.endClause();
+        countClause(buffer, 4);
     }
     inline void addClause(const std::initializer_list<int> &lits)
     {
+        ClauseBuffer &buffer = sink();
         for (int lit : lits)
-        {
-            assert(lit != 0);
-            ipasir_add(_solver, lit);
-            if (_print_formula)
-                _out << lit << " ";
-        }
-        ipasir_add(_solver, 0);
-        if (_print_formula)
-            _out << "0\n";
-        _stats._num_cls++;
-        _stats._num_lits += lits.size();
+            buffer.add(lit);
+        buffer.endClause();
+        countClause(buffer, lits.size());
     }
     inline void addClause(const std::vector<int> &cls)
     {
+        ClauseBuffer &buffer = sink();
         for (int lit : cls)
-        {
-            assert(lit != 0);
-            ipasir_add(_solver, lit);
-            if (_print_formula)
-                _out << lit << " ";
-        }
-        ipasir_add(_solver, 0);
-        if (_print_formula)
-            _out << "0\n";
-        _stats._num_cls++;
-        _stats._num_lits += cls.size();
+            buffer.add(lit);
+        buffer.endClause();
+        countClause(buffer, cls.size());
     }
-    inline void appendClause(int lit)
+    inline void appendClause(int lit) override
     {
-        _began_line = true;
-        assert(lit != 0);
-        ipasir_add(_solver, lit);
-        if (_print_formula)
-            _out << lit << " ";
-        _stats._num_lits++;
+        sink().add(lit);
     }
     inline void appendClause(int lit1, int lit2)
     {
-        _began_line = true;
-        assert(lit1 != 0);
-        assert(lit2 != 0);
-        ipasir_add(_solver, lit1);
-        ipasir_add(_solver, lit2);
-        if (_print_formula)
-            _out << lit1 << " " << lit2 << " ";
-        _stats._num_lits += 2;
+        ClauseBuffer &buffer = sink();
+        buffer.add(lit1);
+        buffer.add(lit2);
     }
     inline void appendClause(const std::initializer_list<int> &lits)
     {
-        _began_line = true;
+        ClauseBuffer &buffer = sink();
         for (int lit : lits)
-        {
-            assert(lit != 0);
-            ipasir_add(_solver, lit);
-            if (_print_formula)
-                _out << lit << " ";
-            // log("%i ", lit);
-        }
-
-        _stats._num_lits += lits.size();
+            buffer.add(lit);
     }
-    inline void endClause()
+    inline void endClause() override
     {
-        assert(_began_line);
-        ipasir_add(_solver, 0);
-        if (_print_formula)
-            _out << "0\n";
-        // log("0\n");
-        _began_line = false;
-
-        _stats._num_cls++;
+        ClauseBuffer &buffer = sink();
+        int num_lits = buffer.endClause();
+        countClause(buffer, num_lits);
     }
 
     inline void assume(int lit)
     {
         if (_stats._num_asmpts == 0)
             _last_assumptions.clear();
-        ipasir_assume(_solver, lit);
+        for (void *solver : _solvers)
+            ipasir_assume(solver, lit);
         // log("CNF !%i\n", lit);
         _last_assumptions.push_back(lit);
         _stats._num_asmpts++;
@@ -185,12 +192,17 @@ public:
 
     inline bool holds(int lit)
     {
-        return ipasir_val(_solver, lit) > 0;
+        return ipasir_val(_solvers[_winner], lit) > 0;
     }
 
     inline bool didAssumptionFail(int lit)
     {
-        return ipasir_failed(_solver, lit);
+        return ipasir_failed(_solvers[_winner], lit);
+    }
+
+    const std::vector<int> &getLastAssumptions() const
+    {
+        return _last_assumptions;
     }
 
     bool hasLastAssumptions()
@@ -200,18 +212,27 @@ public:
 
     void setTerminateCallback(void *state, int (*terminate)(void *state))
     {
-        ipasir_set_terminate(_solver, state, terminate);
+        _terminate_state = state;
+        _terminate = terminate;
+        // In portfolio mode, the callback is already installed and forwards to the user callback
+        if (_solvers.size() == 1)
+            ipasir_set_terminate(_solvers[0], state, terminate);
     }
 
+    // Note: in portfolio mode, the callback is called concurrently by all the solvers
     void setLearnCallback(int maxLength, void *state, void (*learn)(void *state, int *clause))
     {
-        ipasir_set_learn(_solver, state, maxLength, learn);
+        for (void *solver : _solvers)
+            ipasir_set_learn(solver, state, maxLength, learn);
     }
 
     int solve()
     {
+        flush();
+        if (_trace)
+            _trace->writeAssumptions(_stats._num_asmpts > 0 ? _last_assumptions : std::vector<int>());
         _stats.beginTiming(TimingStage::SOLVER);
-        int result = ipasir_solve(_solver);
+        int result = _solvers.size() == 1 ? ipasir_solve(_solvers[0]) : solvePortfolio();
         if (_stats._num_asmpts == 0)
             _last_assumptions.clear();
         _stats._num_asmpts = 0;
@@ -219,83 +240,275 @@ public:
         return result;
     }
 
-    inline void print_formula(std::string filename) {
+    // Write the formula so far in the DIMACS format, with the last assumptions as unit clauses.
+    // Requires an uncompressed trace (-wf=1 -wfCompress=none), which is read back.
+    void print_formula(const std::string &filename)
+    {
+        if (!_trace || _params.getParam("wfCompress") != "none")
+        {
+            Log::w("Writing the formula to %s requires an uncompressed trace (-wf=1 -wfCompress=none)\n", filename.c_str());
+            return;
+        }
+        flush();
+        _trace->flush();
 
-        // std::cout << "WRITING FORMULA TO FILE: " << filename << std::endl;
+        std::ofstream ffile(filename);
+        ffile << "p cnf " << VariableProvider::getMaxVar() << " " << (_stats._num_cls + _last_assumptions.size()) << "\n";
+        std::ifstream trace(_trace_path);
+        std::string line;
+        while (std::getline(trace, line))
+        {
+            // Only the clauses of the trace
+            if (!line.empty() && line[0] != 'p' && line[0] != 'a' && line[0] != 'c')
+                ffile << line << "\n";
+        }
+        for (int asmpt : _last_assumptions)
+        {
+            ffile << asmpt << " 0\n";
+        }
+    }
 
-        // Create final formula file
-        std::ofstream ffile;
-        ffile.open(filename);
+    // Add a comment to the formula trace (if any)
+    void traceComment(const std::string &comment)
+    {
+        if (_trace)
+            _trace->writeComment(comment);
+    }
 
-        ffile << "p cnf " << VariableProvider::getMaxVar() << " " << (_stats._num_cls+_last_assumptions.size()) << "\n";
+    // Give the pending clauses to the solver(s)
+    void flush()
+    {
+        if (_trace)
+            flushPending(TraceFormulaOutput{*_trace});
+        else
+            flushPending(NoFormulaOutput{});
+    }
 
-        ffile << "c assumptions\n";
-        for (int asmpt : _last_assumptions) {
-            ffile << asmpt << " 0\n";
-        }
-        ffile << "c end assumptions\n";
+    // Keep the clauses added by the calling thread aside (e.g. while another thread is solving)
+    void beginBuffering()
+    {
+        assert(_thread_sink == nullptr);
+        _thread_sink = &_held;
+    }
 
-        // Write the content of _out to the file
-        _out.flush();
-        std::ifstream oldfile;
-        oldfile.open("formula.cnf");
-        std::string line;
-        while (std::getline(oldfile, line)) {
-            line = line + "\n";
-            ffile.write(line.c_str(), line.size());
+    // Stop keeping aside the clauses added by the calling thread
+    void endBuffering()
+    {
+        assert(_thread_sink == &_held);
+        _thread_sink = nullptr;
+    }
+
+    // Add the clauses kept aside to the formula. Must not be called while a thread is buffering.
+    void flushBuffer()
+    {
+        _pending.append(_held);
+        _held.clear();
+    }
+
+    // Forget the clauses kept aside. Must not be called while a thread is buffering.
+    void discardBuffer()
+    {
+        _held.clear();
+    }
+
+    // Write the clauses added by the calling thread into the given buffer (or stop doing so with nullptr).
+    // These clauses are not counted in the statistics: they are counted once added with addClauses.
+    // Returns the buffer previously used by the thread, which must be restored afterwards.
+    static ClauseBuffer *redirectThreadClauses(ClauseBuffer *buffer)
+    {
+        ClauseBuffer *previous = _thread_sink;
+        _thread_sink = buffer;
+        return previous;
+    }
+
+    // Add the clauses of a buffer, in which the local variables (see VariableProvider::beginLocalVariables)
+    // are numbered from first_local_var
+    void addClauses(const ClauseBuffer &clauses, int first_local_var)
+    {
+        ClauseBuffer &buffer = sink();
+        buffer.append(clauses, VariableProvider::LOCAL_VAR_BASE, first_local_var - VariableProvider::LOCAL_VAR_BASE);
+        _stats._num_cls += clauses.getNumClauses();
+        _stats._num_lits += clauses.getNumLiterals();
+        if (&buffer == &_pending && _pending.getLiterals().size() >= MAX_PENDING_LITERALS)
+            flush();
+    }
+
+    void addAuxiliaryVariable(int var) override
+    {
+        setNoDecision(var);
+    }
+
+    // With -decisionOpsOnly, the solver(s) will not branch on this variable. The solver stops as soon as
+    // all the decision variables are assigned, so this is only sound if the clauses fix the value of the
+    // variable by propagation from the decision variables, or can always be satisfied by completing it.
+    inline void setNoDecision(int var)
+    {
+        if (_restrict_decisions)
+            sink().addNoDecisionVariable(var);
+    }
+
+    // Make the given variables decision variables again (e.g. their value is not determined anymore)
+    void releaseNoDecisionVariables(const std::vector<int> &vars)
+    {
+        if (!_restrict_decisions)
+            return;
+        flush();
+        for (int var : vars)
+        {
+            if (_no_decision_variables.erase(var) == 0)
+                continue;
+            for (void *solver : _solvers)
+                ipasir_set_decision_var(solver, var, true);
         }
+    }
 
-        // Finish
-        ffile.flush();
-        ffile.close();
+    // Lift the restriction of the decisions for the next solve calls (or set it again), e.g. for the solve
+    // calls which do not assume the conditions under which the variables are determined by propagation
+    void setDecisionsRestricted(bool restricted)
+    {
+        if (!_restrict_decisions || restricted == _decisions_restricted)
+            return;
+        flush();
+        _decisions_restricted = restricted;
+        for (int var : _no_decision_variables)
+        {
+            for (void *solver : _solvers)
+                ipasir_set_decision_var(solver, var, !restricted);
+        }
+    }
 
+    size_t getNumNoDecisionVariables() const
+    {
+        return _no_decision_variables.size();
     }
 
     inline void setPhase(int var, bool phase)
     {
-        ipasir_set_phase(_solver, var, phase);
+        if (_seeded_phases.size() <= (size_t)var)
+            _seeded_phases.resize(var + 1, false);
+        _seeded_phases[var] = true;
+        for (void *solver : _solvers)
+            ipasir_set_phase(solver, var, phase);
     }
 
     ~SatInterface()
     {
-        if (_print_formula)
+        flush();
+        _trace.reset();
+
+        // Release SAT solvers
+        for (void *solver : _solvers)
+            ipasir_release(solver);
+    }
+
+private:
+    inline ClauseBuffer &sink()
+    {
+        return _thread_sink != nullptr ? *_thread_sink : _pending;
+    }
+
+    // The statistics are updated once per clause
+    inline void countClause(ClauseBuffer &buffer, int num_lits)
+    {
+        // Clauses of a redirected thread are counted when they are added (see addClauses)
+        if (&buffer != &_pending && &buffer != &_held)
+            return;
+        _stats._num_lits += num_lits;
+        _stats._num_cls++;
+        if (&buffer == &_pending && _pending.getLiterals().size() >= MAX_PENDING_LITERALS)
+            flush();
+    }
+
+    // Output policies of the formula when the clauses are given to the solver(s)
+    struct NoFormulaOutput
+    {
+        inline void write(const std::vector<int> &/*lits*/) {}
+    };
+    struct TraceFormulaOutput
+    {
+        IcnfWriter &trace;
+        inline void write(const std::vector<int> &lits)
         {
+            trace.writeClauses(lits);
+        }
+    };
 
-            for (int asmpt : _last_assumptions)
-            {
-                _out << asmpt << " 0\n";
-            }
-            _out.flush();
-            _out.close();
-
-            // Create final formula file
-            std::ofstream ffile;
-            std::string filename = "f.cnf";
-            ffile.open(filename);
-
-            // Append header to formula file
-            ffile << "p cnf " << "100" << " " << (_stats._num_cls + _last_assumptions.size()) << "\n";
-
-            // Append main content to formula file (reading from "old" file)
-            std::ifstream oldfile;
-            oldfile.open("formula.cnf");
-            std::string line;
-            while (std::getline(oldfile, line))
-            {
-                line = line + "\n";
-                ffile.write(line.c_str(), line.size());
-            }
+    template <class FormulaOutput>
+    void flushPending(FormulaOutput output)
+    {
+        const std::vector<int> &lits = _pending.getLiterals();
+        for (void *solver : _solvers)
+        {
+            for (int lit : lits)
+                ipasir_add(solver, lit);
+        }
+        output.write(lits);
+        for (int var : _pending.getNoDecisionVariables())
+        {
+            for (void *solver : _solvers)
+                ipasir_set_decision_var(solver, var, !_decisions_restricted);
+        }
+        _no_decision_variables.insert(_pending.getNoDecisionVariables().begin(), _pending.getNoDecisionVariables().end());
+        _pending.clear();
+    }
 
-            oldfile.close();
-            remove("formula.cnf");
+    static int terminatePortfolio(void *state)
+    {
+        SatInterface *sat = static_cast<SatInterface *>(state);
+        if (sat->_race_finished)
+            return 1;
+        return sat->_terminate != nullptr && sat->_terminate(sat->_terminate_state);
+    }
 
-            // Finish
-            ffile.flush();
-            ffile.close();
+    /**
+     * Run all the solvers of the portfolio in parallel on the current formula and assumptions.
+     * The first solver to answer SAT or UNSAT wins, the others are interrupted through the
+     * terminate callback. Returns the answer of the winner (or 0 if all solvers were interrupted).
+     */
+    int solvePortfolio()
+    {
+        diversifyPhases();
+
+        _race_finished = false;
+        std::atomic<int> winner(-1);
+        std::vector<int> results(_solvers.size(), 0);
+        std::vector<std::thread> threads;
+        threads.reserve(_solvers.size());
+        for (size_t i = 0; i < _solvers.size(); i++)
+        {
+            threads.emplace_back([this, i, &results, &winner]()
+                                 {
+                results[i] = ipasir_solve(_solvers[i]);
+                int expected = -1;
+                if (results[i] != 0 && winner.compare_exchange_strong(expected, (int)i))
+                    _race_finished = true; });
         }
+        for (std::thread &thread : threads)
+            thread.join();
 
-        // Release SAT solver
-        ipasir_release(_solver);
+        if (winner < 0)
+            return 0;
+        _winner = winner;
+        return results[_winner];
+    }
+
+    // Give the new variables a phase depending on the solver of the portfolio: the first one keeps the
+    // default behaviour of the solver, the next ones cycle through all true, random and all false.
+    // The variables already given a phase by setPhase keep it in all the solvers.
+    void diversifyPhases()
+    {
+        int max_var = VariableProvider::getMaxVar();
+        for (size_t i = 1; i < _solvers.size(); i++)
+        {
+            for (int var = _num_diversified_vars + 1; var <= max_var; var++)
+            {
+                if ((size_t)var < _seeded_phases.size() && _seeded_phases[var])
+                    continue;
+                bool phase = i % 3 == 1 || (i % 3 == 2 && (_phase_generators[i]() & 1));
+                ipasir_set_phase(_solvers[i], var, phase);
+            }
+        }
+        _num_diversified_vars = max_var;
     }
 };
 
@@ -1,13 +1,37 @@
+#include <assert.h>
+
 #include "sat/variable_provider.h"
 
-int VariableProvider::_running_var_id = 1;
+std::atomic<int> VariableProvider::_running_var_id{1};
+thread_local int VariableProvider::_num_local_vars = -1;
 
 int VariableProvider::nextVar()
 {
-    return _running_var_id++;
+    if (_num_local_vars >= 0)
+        return LOCAL_VAR_BASE + _num_local_vars++;
+    return _running_var_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+int VariableProvider::nextVars(int count)
+{
+    return _running_var_id.fetch_add(count, std::memory_order_relaxed);
 }
 
 int VariableProvider::getMaxVar()
 {
     return _running_var_id - 1;
-}
\ No newline at end of file
+}
+
+void VariableProvider::beginLocalVariables()
+{
+    assert(_num_local_vars < 0);
+    _num_local_vars = 0;
+}
+
+int VariableProvider::endLocalVariables()
+{
+    assert(_num_local_vars >= 0);
+    int num_local_vars = _num_local_vars;
+    _num_local_vars = -1;
+    return num_local_vars;
+}
@@ -1,15 +1,37 @@
 #ifndef VARIABLE_PROVIDER_H
 #define VARIABLE_PROVIDER_H
 
+#include <atomic>
+
+// Thread safe: variables may be requested concurrently (e.g. by encoding and solving threads)
 class VariableProvider
 {
 
 private:
-    static int _running_var_id;
+    static std::atomic<int> _running_var_id;
+    // Number of local variables given to the calling thread, or -1 if it is not in local mode
+    static thread_local int _num_local_vars;
 
 public:
+    // Local variables are numbered from this value
+    static constexpr int LOCAL_VAR_BASE = 1 << 30;
+
     static int nextVar();
+    // Reserve count consecutive variables and return the first one
+    static int nextVars(int count);
     static int getMaxVar();
+
+    // Between these two calls, nextVar gives the calling thread local variables LOCAL_VAR_BASE,
+    // LOCAL_VAR_BASE + 1, ... instead of global ones. This allows to number the variables of
+    // clauses generated in parallel in a deterministic way: once the clauses are merged, the local
+    // variables are mapped to a range obtained with nextVars(<number of local variables>).
+    static void beginLocalVariables();
+    // Return the number of local variables created since beginLocalVariables
+    static int endLocalVariables();
+    static bool isLocalVariable(int var)
+    {
+        return var >= LOCAL_VAR_BASE;
+    }
 };
 
-#endif // VARIABLE_PROVIDER_H
\ No newline at end of file
+#endif // VARIABLE_PROVIDER_H
@@ -0,0 +1,142 @@
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 64-bit FNV-1a hash of some bytes, continuing from a previous hash
+inline uint64_t fnv1a(std::string_view data, uint64_t hash = 14695981039346656037ULL)
+{
+    for (unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Values appended in their native representation to a byte string
+class BinaryWriter
+{
+
+private:
+    std::string _data;
+
+public:
+    void writeInt(int32_t value)
+    {
+        _data.append((const char *)&value, sizeof(value));
+    }
+
+    void writeU64(uint64_t value)
+    {
+        _data.append((const char *)&value, sizeof(value));
+    }
+
+    void writeString(std::string_view value)
+    {
+        writeInt(value.size());
+        _data.append(value.data(), value.size());
+    }
+
+    // Number of values, then the values
+    template <class Container>
+    void writeInts(const Container &values)
+    {
+        writeInt(values.size());
+        for (int value : values)
+            writeInt(value);
+    }
+
+    const std::string &getData() const
+    {
+        return _data;
+    }
+};
+
+// Reads back the values of a BinaryWriter. Reading past the end is not an error by itself: it returns
+// zeros and marks the reader as failed, to be checked once with ok().
+class BinaryReader
+{
+
+private:
+    const char *_pos;
+    const char *_end;
+    bool _ok = true;
+
+    bool take(void *dest, size_t num_bytes)
+    {
+        if (!_ok || (size_t)(_end - _pos) < num_bytes)
+        {
+            _ok = false;
+            return false;
+        }
+        memcpy(dest, _pos, num_bytes);
+        _pos += num_bytes;
+        return true;
+    }
+
+public:
+    explicit BinaryReader(std::string_view data) : _pos(data.data()), _end(data.data() + data.size()) {}
+
+    bool ok() const
+    {
+        return _ok;
+    }
+
+    bool atEnd() const
+    {
+        return _pos == _end;
+    }
+
+    // Mark the data as invalid, for checks made by the caller
+    void fail()
+    {
+        _ok = false;
+    }
+
+    int32_t readInt()
+    {
+        int32_t value = 0;
+        take(&value, sizeof(value));
+        return value;
+    }
+
+    uint64_t readU64()
+    {
+        uint64_t value = 0;
+        take(&value, sizeof(value));
+        return value;
+    }
+
+    // Size of a sequence of elements of num_bytes each, 0 if it does not fit in the remaining data
+    size_t readSize(size_t num_bytes)
+    {
+        int32_t size = readInt();
+        if (size < 0 || (size_t)(_end - _pos) < (size_t)size * num_bytes)
+        {
+            _ok = false;
+            return 0;
+        }
+        return size;
+    }
+
+    std::string readString()
+    {
+        std::string value(readSize(1), '\0');
+        take(value.data(), value.size());
+        return value;
+    }
+
+    std::vector<int> readInts()
+    {
+        std::vector<int> values(readSize(sizeof(int32_t)));
+        take(values.data(), values.size() * sizeof(int32_t));
+        return values;
+    }
+};
+
+#endif // BINARY_IO_H
@@ -3,6 +3,15 @@
 #include <cstdlib>
 #include <filesystem>
 #include <array>
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
 
 int runCommand(const std::string &command, const std::string &error_message)
 {
@@ -30,3 +39,93 @@ bool checkCommandOutput(const std::string &command, const std::string &searchStr
 
     return result.find(searchString) != std::string::npos;
 }
+
+// Pipe whose ends are above the fds 3 and 4 used by the pipeline, and not inherited by default
+static bool createPipe(int fds[2])
+{
+    if (pipe2(fds, O_CLOEXEC) != 0)
+        return false;
+    for (int i = 0; i < 2; i++)
+    {
+        if (fds[i] > 4)
+            continue;
+        int fd = fcntl(fds[i], F_DUPFD_CLOEXEC, 5);
+        close(fds[i]);
+        fds[i] = fd;
+    }
+    return fds[0] >= 0 && fds[1] >= 0;
+}
+
+bool runPipeline(const std::vector<std::vector<std::string>> &commands, std::string &output)
+{
+    output.clear();
+    std::vector<pid_t> pids;
+    bool success = true;
+    int input_fd = -1;
+    for (size_t i = 0; i < commands.size() && success; i++)
+    {
+        int fds[2];
+        if (!createPipe(fds))
+        {
+            success = false;
+            break;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        if (input_fd >= 0)
+            posix_spawn_file_actions_adddup2(&actions, input_fd, 3);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], 4);
+
+        std::vector<char *> argv;
+        for (const std::string &arg : commands[i])
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        pid_t pid;
+        Log::d("Executing command %zu of the pipeline: %s\n", i, commands[i][0].c_str());
+        if (posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ) == 0)
+            pids.push_back(pid);
+        else
+            success = false;
+        posix_spawn_file_actions_destroy(&actions);
+
+        // The ends given to the child are only used by it from now on
+        close(fds[1]);
+        if (input_fd >= 0)
+            close(input_fd);
+        input_fd = fds[0];
+    }
+
+    if (input_fd >= 0)
+    {
+        if (success)
+        {
+            std::array<char, 1 << 16> buffer;
+            ssize_t num_read;
+            while ((num_read = read(input_fd, buffer.data(), buffer.size())) != 0)
+            {
+                if (num_read < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    success = false;
+                    break;
+                }
+                output.append(buffer.data(), num_read);
+            }
+        }
+        close(input_fd);
+    }
+
+    for (pid_t pid : pids)
+    {
+        int status;
+        pid_t res;
+        while ((res = waitpid(pid, &status, 0)) < 0 && errno == EINTR)
+            ;
+        if (res < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            success = false;
+    }
+    return success;
+}
@@ -2,6 +2,7 @@
 #define COMMAND_UTILS_H
 
 #include <string>
+#include <vector>
 
 /**
  * Execute a system command and return its success status.
@@ -21,4 +22,19 @@ int runCommand(const std::string &command, const std::string &error_message);
  */
 bool checkCommandOutput(const std::string &command, const std::string &searchString);
 
+// Paths under which each command of a pipeline reads the output of the previous one and writes its own output
+#define PIPELINE_INPUT_PATH "/dev/fd/3"
+#define PIPELINE_OUTPUT_PATH "/dev/fd/4"
+
+/**
+ * Execute a chain of commands directly (without a shell), each one writing into PIPELINE_OUTPUT_PATH
+ * and the next one reading it from PIPELINE_INPUT_PATH. The output of the last command is collected
+ * in memory. The standard streams of the commands are inherited, so that their logs are not mixed with the data.
+ *
+ * @param commands The commands, as lists of arguments (the first one being the executable).
+ * @param output Filled with the output of the last command.
+ * @return true if all the commands could be started and exited with status 0.
+ */
+bool runPipeline(const std::vector<std::vector<std::string>> &commands, std::string &output);
+
 #endif // COMMAND_UTILS_H
@@ -0,0 +1,191 @@
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Set stored as a sorted vector. Most sets of the tree nodes are small and are filled in
+// (nearly) increasing order, so an insertion is usually a push_back and a lookup a binary
+// search over contiguous memory, without one heap allocation per element.
+template <class T, class Compare = std::less<T>>
+class FlatSet
+{
+private:
+    std::vector<T> _elems;
+    Compare _comp;
+
+    bool equal(const T &a, const T &b) const
+    {
+        return !_comp(a, b) && !_comp(b, a);
+    }
+
+public:
+    using value_type = T;
+    using iterator = typename std::vector<T>::const_iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    FlatSet() = default;
+    explicit FlatSet(std::vector<T> elems) : _elems(std::move(elems))
+    {
+        std::sort(_elems.begin(), _elems.end(), _comp);
+        _elems.erase(std::unique(_elems.begin(), _elems.end(), [this](const T &a, const T &b)
+                                 { return equal(a, b); }),
+                     _elems.end());
+    }
+
+    bool insert(const T &value)
+    {
+        if (_elems.empty() || _comp(_elems.back(), value))
+        {
+            _elems.push_back(value);
+            return true;
+        }
+        auto it = std::lower_bound(_elems.begin(), _elems.end(), value, _comp);
+        if (it != _elems.end() && equal(*it, value))
+            return false;
+        _elems.insert(it, value);
+        return true;
+    }
+
+    // Insert all the elements of another set with a single merge
+    void insert(const FlatSet &other)
+    {
+        if (other._elems.empty())
+            return;
+        if (_elems.empty())
+        {
+            _elems = other._elems;
+            return;
+        }
+        size_t old_size = _elems.size();
+        _elems.insert(_elems.end(), other._elems.begin(), other._elems.end());
+        std::inplace_merge(_elems.begin(), _elems.begin() + old_size, _elems.end(), _comp);
+        _elems.erase(std::unique(_elems.begin(), _elems.end(), [this](const T &a, const T &b)
+                                 { return equal(a, b); }),
+                     _elems.end());
+    }
+
+    const_iterator find(const T &value) const
+    {
+        auto it = std::lower_bound(_elems.begin(), _elems.end(), value, _comp);
+        if (it != _elems.end() && equal(*it, value))
+            return it;
+        return _elems.end();
+    }
+
+    size_t count(const T &value) const { return find(value) != _elems.end() ? 1 : 0; }
+    bool contains(const T &value) const { return find(value) != _elems.end(); }
+
+    size_t erase(const T &value)
+    {
+        auto it = find(value);
+        if (it == _elems.end())
+            return 0;
+        _elems.erase(it);
+        return 1;
+    }
+
+    template <class Predicate>
+    size_t eraseIf(Predicate pred)
+    {
+        size_t old_size = _elems.size();
+        _elems.erase(std::remove_if(_elems.begin(), _elems.end(), pred), _elems.end());
+        return old_size - _elems.size();
+    }
+
+    const_iterator begin() const { return _elems.begin(); }
+    const_iterator end() const { return _elems.end(); }
+    size_t size() const { return _elems.size(); }
+    bool empty() const { return _elems.empty(); }
+    void clear() { _elems.clear(); }
+    void reserve(size_t n) { _elems.reserve(n); }
+};
+
+// Map stored as a vector of {key, value} pairs sorted by key (see FlatSet).
+// As with a vector, inserting a key invalidates the references to the other values.
+template <class K, class V, class Compare = std::less<K>>
+class FlatMap
+{
+private:
+    std::vector<std::pair<K, V>> _elems;
+    Compare _comp;
+
+    typename std::vector<std::pair<K, V>>::iterator lowerBound(const K &key)
+    {
+        return std::lower_bound(_elems.begin(), _elems.end(), key, [this](const std::pair<K, V> &elem, const K &k)
+                                { return _comp(elem.first, k); });
+    }
+
+    typename std::vector<std::pair<K, V>>::const_iterator lowerBound(const K &key) const
+    {
+        return std::lower_bound(_elems.begin(), _elems.end(), key, [this](const std::pair<K, V> &elem, const K &k)
+                                { return _comp(elem.first, k); });
+    }
+
+public:
+    using value_type = std::pair<K, V>;
+    using iterator = typename std::vector<std::pair<K, V>>::iterator;
+    using const_iterator = typename std::vector<std::pair<K, V>>::const_iterator;
+
+    V &operator[](const K &key)
+    {
+        if (_elems.empty() || _comp(_elems.back().first, key))
+        {
+            _elems.emplace_back(key, V());
+            return _elems.back().second;
+        }
+        auto it = lowerBound(key);
+        if (it == _elems.end() || _comp(key, it->first))
+            it = _elems.emplace(it, key, V());
+        return it->second;
+    }
+
+    iterator find(const K &key)
+    {
+        auto it = lowerBound(key);
+        if (it != _elems.end() && !_comp(key, it->first))
+            return it;
+        return _elems.end();
+    }
+
+    const_iterator find(const K &key) const
+    {
+        auto it = lowerBound(key);
+        if (it != _elems.end() && !_comp(key, it->first))
+            return it;
+        return _elems.end();
+    }
+
+    const V &at(const K &key) const
+    {
+        auto it = find(key);
+        if (it == _elems.end())
+            throw std::out_of_range("FlatMap::at");
+        return it->second;
+    }
+
+    V &at(const K &key)
+    {
+        auto it = find(key);
+        if (it == _elems.end())
+            throw std::out_of_range("FlatMap::at");
+        return it->second;
+    }
+
+    size_t count(const K &key) const { return find(key) != _elems.end() ? 1 : 0; }
+    bool contains(const K &key) const { return find(key) != _elems.end(); }
+
+    iterator begin() { return _elems.begin(); }
+    iterator end() { return _elems.end(); }
+    const_iterator begin() const { return _elems.begin(); }
+    const_iterator end() const { return _elems.end(); }
+    size_t size() const { return _elems.size(); }
+    bool empty() const { return _elems.empty(); }
+    void clear() { _elems.clear(); }
+    void reserve(size_t n) { _elems.reserve(n); }
+};
+
+#endif // FLAT_MAP_H
@@ -0,0 +1,44 @@
+#include "util/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile()
+{
+    if (_data != nullptr)
+        munmap(_data, _size);
+}
+
+bool MappedFile::open(const std::string &filepath)
+{
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    _size = st.st_size;
+    if (_size == 0)
+    {
+        // Nothing to map, the contents are empty
+        close(fd);
+        return true;
+    }
+
+    void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        _size = 0;
+        return false;
+    }
+    madvise(data, _size, MADV_SEQUENTIAL);
+    _data = data;
+    return true;
+}
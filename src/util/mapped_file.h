@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile
+{
+
+private:
+    void *_data = nullptr;
+    size_t _size = 0;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Map the file, return false if it cannot be opened or mapped
+    bool open(const std::string &filepath);
+
+    std::string_view getContents() const
+    {
+        return std::string_view((const char *)_data, _size);
+    }
+};
+
+#endif // MAPPED_FILE_H
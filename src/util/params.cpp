@@ -52,17 +52,52 @@ void Parameters::setDefaults()
     setParam("cleanup", "1"); // clean up before exit?
     setParam("co", "1");      // colored output
     setParam("s", "0");       // random seed
+    setParam("T", "0");       // Wall-clock time limit in seconds (0: none)
+    setParam("solveT", "0");  // Time limit in seconds of a solve call at the first layer (0: none)
+    setParam("solveTGrowth", "2"); // Factor of the time limit of the solve calls at each new layer
+    setParam("mem", "0");     // Limit of the resident memory in MB (0: none)
+    setParam("maxDepth", "50"); // Maximum number of layers
+    setParam("anytime", "0"); // Once a plan is found, output plans with fewer actions until none exists or the time limit is reached
     setParam("v", "2");       // verbosity
     setParam("vp", "0");      // Verify plan
-    setParam("wf", "0");      // output formula to f.cnf
-    setParam("wp", "0");      // output plan to plan.txt
+    setParam("wf", "0");      // Write the formula and the solve calls as an incremental CNF trace (iCNF)
+    setParam("wfFile", ""); // File of the formula trace (default: f.icnf in the scratch directory of the run, which is then kept)
+    setParam("wfCompress", "none"); // Command compressing the formula trace through a pipe (e.g. "gzip -c", "zstd -q"), or none
+    setParam("wp", "0");      // output plan to -wpFile
+    setParam("wpFile", ""); // File of the plan (default: plan.txt in the scratch directory of the run, which is then kept)
     setParam("pvn", "0");     // Print variable names
     setParam("po", "1");      // Partial order encoding
     setParam("mutex", "1");   // Use mutexes during the encoding (enabled by default)
     setParam("precsEffs", "0"); // Compute and use preconditions and effects of methods
     setParam("nsp", "0");     // No split parameters
+    setParam("grounded", "0"); // The problem file is already grounded by pandaPIgrounder (the parsing and grounding are skipped)
+    setParam("workdir", ""); // Directory in which each run creates its own scratch directory ("tmpfs": in memory; default: ProblemProcessing/)
+    setParam("keepWorkdir", "0"); // Keep the scratch directory of the run (intermediate files) at exit
+    setParam("server", ""); // Serve the requests received on this Unix socket (see algo/planner_server.h) instead of solving a single problem
+    setParam("serverWorkers", "0"); // Maximum number of requests handled at the same time by the server (0: number of cores)
+    setParam("dagTest", "0"); // Run the self-test of the DAG compressor at startup
+    setParam("snapshots", "0"); // Reuse a binary snapshot of the preprocessed instance from a previous run with the same inputs
+    setParam("snapshotDir", "snapshots"); // Directory of the snapshots (relative to the project root)
+    setParam("loadThreads", "1"); // Number of threads parsing the actions and methods of the grounded problem
+    setParam("pipeGrounding", "1"); // Chain the parser and the grounder through pipes instead of intermediate files (falls back to the files on failure)
+    setParam("simplifyPreds", "0"); // Remove the rigid and irrelevant predicates after grounding
     setParam("removeMethodPrecAction", "0"); // Remove the special first subtask of the method which contains its preconditions and set instead the preconditions at the method level
     setParam("sibylsat", "1"); // Use the sibylsat expansion
+    setParam("lazyTransitivity", "0"); // Only add the transitivity clauses of the before variables violated by the models
+    setParam("pipeline", "0"); // Expand and encode the next layer in a background thread while solving the current one
+    setParam("portfolio", "1"); // Number of solvers (different phases and random decisions) racing on each solve call (the phases given by -phaseSaving are kept by all of them)
+    setParam("factAliasing", "0"); // For a node with a unique possible previous node, replace the frame axioms of the facts this previous node cannot change by equalities (unless the leaf overleaf is true)
+    setParam("effectSupportVars", "0"); // One variable per node and predicate for the ops which can change it, shared by the frame axioms towards all the next nodes
+    setParam("amo", "legacy"); // At-most-one encoding: legacy, auto, pairwise, sequential, ladder, commander, product, binary or bimander
+    setParam("amoNext", "amo"); // At-most-one encoding of the next / previous nodes ("amo": the one of -amo)
+    setParam("amoOps", "amo"); // At-most-one encoding of the ops of a node ("amo": the one of -amo)
+    setParam("amoMutex", "amo"); // At-most-one encoding of the mutex groups ("amo": the one of -amo)
+    setParam("amoGroupSize", "0"); // Group size of the commander and bimander encodings (0: chosen by the encoding)
+    setParam("phaseSaving", "0"); // Sibylsat: initialize the phases of the variables of a new layer from the relaxed solution of the previous one (in all the solvers of -portfolio)
+    setParam("decisionOpsOnly", "0"); // The solver does not branch on the AMO auxiliary variables, nor on the facts of the last layer which the ops and the ordering determine (nodes after action-only nodes, leaf overleaf assumed false)
+    setParam("coreRelaxation", "0"); // Sibylsat: in the relaxed solve, keep the prim assumptions of the leaves which are not in the failed core
+    setParam("relevantMutexes", "0"); // Encode the mutex groups of a node only for the facts which its previous nodes may make true
+    setParam("encodingThreads", "1"); // Number of threads encoding the leaf nodes of a layer (the formula does not depend on it)
 }
 
 void Parameters::printUsage()
@@ -76,7 +111,7 @@ void Parameters::printUsage()
     Log::i("\n");
     Log::i("Option syntax: -OPTION or -OPTION=VALUE .\n");
     Log::i("\n");
-    Log::i(" -wf=<0|1>           Write generated formula to text file \"f.cnf\" (with assumptions used in final call)\n");
+    Log::i(" -wf=<0|1>           Write the formula and the solve calls as an iCNF trace to -wfFile (see icnf_replay)\n");
     Log::i("\n");
     printParams();
     Log::setForcePrint(false);
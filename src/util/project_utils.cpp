@@ -2,6 +2,8 @@
 #include <fstream>
 #include <regex>
 #include <stdexcept>
+#include <cstdlib>
+#include <unistd.h>
 
 #include "project_utils.h"
 
@@ -14,17 +16,61 @@ std::filesystem::path getProjectRootDir()
     return std::filesystem::path(TO_STRING(PROJECT_ROOT_DIR));
 }
 
-std::filesystem::path getProblemProcessingDir()
+// Scratch directory of this run, and whether to keep it at exit
+static std::filesystem::path run_dir;
+static bool keep_run_dir = false;
+
+static void removeProblemProcessingDir()
+{
+    if (keep_run_dir || run_dir.empty())
+        return;
+    std::error_code error;
+    std::filesystem::remove_all(run_dir, error);
+}
+
+void initProblemProcessingDir(const std::string &base_dir, bool keep)
 {
-    std::filesystem::path problemProcessingDir = getProjectRootDir() / "ProblemProcessing";
+    std::filesystem::path base = base_dir.empty() ? getProjectRootDir() / "ProblemProcessing" : std::filesystem::path(base_dir);
+    if (base_dir == "tmpfs")
+    {
+        base = std::filesystem::exists("/dev/shm") ? std::filesystem::path("/dev/shm") : std::filesystem::temp_directory_path();
+        base /= "sibylsat-po";
+    }
+    std::filesystem::create_directories(base);
+
+    std::string dir_template = (base / ("run-" + std::to_string(getpid()) + "-XXXXXX")).string();
+    if (mkdtemp(dir_template.data()) == nullptr)
+    {
+        throw std::runtime_error("Could not create a directory in " + base.string());
+    }
 
-    // Check if the directory exists; if not, create it
-    if (!std::filesystem::exists(problemProcessingDir))
+    bool first_init = run_dir.empty();
+    run_dir = dir_template;
+    keep_run_dir = keep;
+    if (first_init)
     {
-        std::filesystem::create_directories(problemProcessingDir);
+        atexit(removeProblemProcessingDir);
     }
+}
+
+std::filesystem::path getProblemProcessingDir()
+{
+    if (run_dir.empty())
+    {
+        initProblemProcessingDir("", false);
+    }
+    return run_dir;
+}
 
-    return problemProcessingDir;
+std::string getRunOutputPath(const std::string &path, const std::string &default_name)
+{
+    if (!path.empty())
+    {
+        return path;
+    }
+    std::filesystem::path dir = getProblemProcessingDir();
+    keep_run_dir = true;
+    return (dir / default_name).string();
 }
 
 std::string getDomaineNameFromDomainFile(const std::string &domainFile)
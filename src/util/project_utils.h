@@ -7,9 +7,18 @@
 // Function to get the project root directory
 std::filesystem::path getProjectRootDir();
 
-// Function to get or create the problem processing directory
+// Create the scratch directory of this run, a new directory of its own inside base_dir, so that concurrent runs
+// never share their intermediate files. base_dir is the ProblemProcessing directory of the project if empty, and
+// a directory in memory (/dev/shm) if "tmpfs". Unless keep is set, the directory is removed when the process exits.
+void initProblemProcessingDir(const std::string &base_dir, bool keep);
+
+// Function to get or create the problem processing directory (the scratch directory of this run)
 std::filesystem::path getProblemProcessingDir();
 
+// Path of an output file of the run: the given path if any, otherwise default_name in the scratch directory,
+// which is then kept at exit
+std::string getRunOutputPath(const std::string &path, const std::string &default_name);
+
 // Get the domain name as defined in the (define (domain <name_domain>) part of the domain file
 std::string getDomaineNameFromDomainFile(const std::string &domainFile);
 
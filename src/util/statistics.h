@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <chrono>
+#include <mutex>
 #include <assert.h>
 
 #include "util/log.h"
@@ -39,6 +40,7 @@ const int STAGE_BEFORE_PREDECESSORS = 26;
 const int STAGE_BEFORE_SUCCESSORS = 27;
 const int STAGE_BEFORE_TRANSITIVITY = 28;
 const int STAGE_BEFORE_HIERARCHY = 29;
+const int STAGE_PARALLEL_NODES = 30;
 
 
 enum class TimingStage
@@ -98,8 +100,22 @@ public:
                _num_lits - _prev_num_lits);
     }
 
+    // Ignore the stages and timings started by the calling thread (e.g. a thread encoding nodes
+    // in parallel, whose clauses are counted once merged)
+    static void muteThread(bool mute)
+    {
+        _thread_muted = mute;
+    }
+
+    static bool isThreadMuted()
+    {
+        return _thread_muted;
+    }
+
     void begin(int stage)
     {
+        if (_thread_muted)
+            return;
         if (!_current_stages.empty())
         {
             int oldStage = _current_stages.back();
@@ -111,12 +127,39 @@ public:
 
     void end(int stage)
     {
+        if (_thread_muted)
+            return;
         assert(!_current_stages.empty() && _current_stages.back() == stage);
         _current_stages.pop_back();
         _num_cls_per_stage[stage] += _num_cls - _num_cls_at_stage_start;
         _num_cls_at_stage_start = _num_cls;
     }
 
+    // Snapshot of the clause counters, used to forget clauses which are finally not given
+    // to the solver (e.g. speculatively encoded layer)
+    struct ClauseCounters
+    {
+        int num_cls = 0;
+        int num_lits = 0;
+        std::vector<int> num_cls_per_stage;
+    };
+
+    ClauseCounters getClauseCounters() const
+    {
+        return {_num_cls, _num_lits, _num_cls_per_stage};
+    }
+
+    // Remove the clauses counted between the two snapshots
+    void removeClauseCounters(const ClauseCounters &from, const ClauseCounters &to)
+    {
+        assert(_current_stages.empty());
+        _num_cls -= to.num_cls - from.num_cls;
+        _num_lits -= to.num_lits - from.num_lits;
+        for (size_t stage = 0; stage < _num_cls_per_stage.size(); stage++)
+            _num_cls_per_stage[stage] -= to.num_cls_per_stage[stage] - from.num_cls_per_stage[stage];
+        _num_cls_at_stage_start = _num_cls;
+    }
+
     // Print a summary of stages and timing
     void printStats()
     {
@@ -160,6 +203,9 @@ public:
 
     void beginTiming(TimingStage stage)
     {
+        if (_thread_muted)
+            return;
+        std::lock_guard<std::mutex> lock(_timing_mutex);
         if (_active_timings.count(stage) > 0)
         {
             Log::w("Warning: Attempted to start timing for stage %s which is already running\n",
@@ -171,6 +217,9 @@ public:
 
     void endTiming(TimingStage stage)
     {
+        if (_thread_muted)
+            return;
+        std::lock_guard<std::mutex> lock(_timing_mutex);
         auto it = _active_timings.find(stage);
         if (it == _active_timings.end())
         {
@@ -188,6 +237,7 @@ public:
 
     long long getTiming(TimingStage stage)
     {
+        std::lock_guard<std::mutex> lock(_timing_mutex);
         return _stage_times_ms[stage];
     }
 
@@ -246,6 +296,8 @@ public:
     }
 
     // Public data members (if needed externally)
+    // Note: the clause counters are only updated by the thread which feeds the solver(s),
+    // the timings can be safely updated from any thread.
     int _num_cls = 0;
     int _num_lits = 0;
     int _num_asmpts = 0;
@@ -264,14 +316,15 @@ private:
 
 private:
     // Stage names
-    const char *STAGES_NAMES[30] = {
+    const char *STAGES_NAMES[31] = {
         "actionconstraints", "actioneffects", "atleastoneelement", "atmostoneelement",
         "axiomaticops", "frameaxioms", "expansions", "factpropagation",
         "factvarencoding", "forbiddenoperations", "indirectframeaxioms", "initsubstitutions",
         "predecessors", "qconstequality", "qfactsemantics", "qtypeconstraints",
         "reductionconstraints", "substitutionconstraints", "truefacts", "assumptions",
         "planlengthcounting", "mutexes", "primitiveness", "beforeclauses", "prec",
-        "eff", "beforepredecessors", "beforesuccessors", "beforetransitivity", "beforehierarchy"};
+        "eff", "beforepredecessors", "beforesuccessors", "beforetransitivity", "beforehierarchy",
+        "parallelnodes"};
 
     // Tracks the total clauses added per stage
     std::vector<int> _num_cls_per_stage;
@@ -287,6 +340,9 @@ private:
     // Timing-related members
     std::map<TimingStage, std::chrono::time_point<std::chrono::high_resolution_clock>> _active_timings;
     std::map<TimingStage, long long> _stage_times_ms;
+    std::mutex _timing_mutex;
+
+    static inline thread_local bool _thread_muted = false;
 };
 
 #endif // STATISTICS_H
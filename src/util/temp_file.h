@@ -9,6 +9,7 @@
 #include <vector>    // For std::vector
 #include <unistd.h>  // For close()
 #include "log.h" // For logging potential cleanup errors (Corrected path)
+#include "project_utils.h"
 
 // Helper RAII class for creating and automatically deleting temporary files.
 class TempFile {
@@ -20,7 +21,8 @@ public:
         // Generate a unique temporary filename using mkstemp.
         // mkstemp is a POSIX function that creates a unique temporary file and returns a file descriptor.
         // It avoids the race condition issues associated with tmpnam.
-        std::filesystem::path temp_path = std::filesystem::temp_directory_path();
+        // Inside the scratch directory of the run (see -workdir)
+        std::filesystem::path temp_path = getProblemProcessingDir();
         temp_path /= "temp_file_XXXXXX"; // mkstemp requires the template to end with "XXXXXX"
         std::string temp_path_str = temp_path.string();
         
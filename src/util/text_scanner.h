@@ -0,0 +1,110 @@
+#ifndef TEXT_SCANNER_H
+#define TEXT_SCANNER_H
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+/**
+ * Line and integer scanner over a text kept in memory (e.g. a MappedFile), without any copy.
+ * A scanner may cover only a part of the text, so that several threads can each parse their own range.
+ */
+class TextScanner
+{
+
+private:
+    const char *_pos;
+    const char *_end;
+
+public:
+    explicit TextScanner(std::string_view text) : _pos(text.data()), _end(text.data() + text.size()) {}
+    TextScanner(const char *begin, const char *end) : _pos(begin), _end(end) {}
+
+    bool atEnd() const
+    {
+        return _pos >= _end;
+    }
+
+    const char *getPosition() const
+    {
+        return _pos;
+    }
+
+    const char *getEnd() const
+    {
+        return _end;
+    }
+
+    // Rest of the current line (without its line break), and go to the next line
+    std::string_view readLine()
+    {
+        const char *line_end = (const char *)memchr(_pos, '\n', _end - _pos);
+        if (line_end == nullptr)
+            line_end = _end;
+        std::string_view line(_pos, line_end - _pos);
+        _pos = line_end < _end ? line_end + 1 : _end;
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return line;
+    }
+
+    void skipLines(size_t num_lines)
+    {
+        for (size_t i = 0; i < num_lines && !atEnd(); i++)
+            readLine();
+    }
+
+    // Go to the line after the first line equal to target. Return false if there is none.
+    bool skipUntilLine(std::string_view target)
+    {
+        while (!atEnd())
+        {
+            if (readLine() == target)
+                return true;
+        }
+        return false;
+    }
+
+    // Next integer of the current line. Return false if the line has no more integers.
+    bool readInt(int &value)
+    {
+        while (_pos < _end && (*_pos == ' ' || *_pos == '\t' || *_pos == '\r'))
+            _pos++;
+        const char *start = _pos;
+        bool negative = _pos < _end && *_pos == '-';
+        if (negative)
+            _pos++;
+        int result = 0;
+        const char *digits = _pos;
+        while (_pos < _end && *_pos >= '0' && *_pos <= '9')
+            result = 10 * result + (*_pos++ - '0');
+        if (_pos == digits)
+        {
+            _pos = start;
+            return false;
+        }
+        value = negative ? -result : result;
+        return true;
+    }
+
+    // Line holding a single integer (0 if there is none)
+    int readIntLine()
+    {
+        int value = 0;
+        readInt(value);
+        readLine();
+        return value;
+    }
+
+    // Integers of the current line up to the terminating -1, and go to the next line
+    void readIntegerList(std::vector<int> &values)
+    {
+        values.clear();
+        int value;
+        while (readInt(value) && value != -1)
+            values.push_back(value);
+        readLine();
+    }
+};
+
+#endif // TEXT_SCANNER_H
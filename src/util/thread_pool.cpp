@@ -0,0 +1,75 @@
+#include "util/thread_pool.h"
+
+ThreadPool::ThreadPool(int num_threads)
+{
+    for (int i = 1; i < num_threads; i++)
+        _workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _start_cv.notify_all();
+    for (std::thread &worker : _workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t num_tasks, const std::function<void(size_t)> &task)
+{
+    if (num_tasks == 0)
+        return;
+    if (_workers.empty() || num_tasks == 1)
+    {
+        for (size_t i = 0; i < num_tasks; i++)
+            task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _num_tasks = num_tasks;
+        _next_task = 0;
+        _num_running_workers = _workers.size();
+        _generation++;
+    }
+    _start_cv.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done_cv.wait(lock, [this]()
+                  { return _num_running_workers == 0; });
+    _task = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+    uint64_t last_generation = 0;
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _start_cv.wait(lock, [this, last_generation]()
+                       { return _stop || _generation != last_generation; });
+        if (_stop)
+            return;
+        last_generation = _generation;
+        lock.unlock();
+
+        runTasks();
+
+        lock.lock();
+        if (--_num_running_workers == 0)
+            _done_cv.notify_one();
+    }
+}
+
+void ThreadPool::runTasks()
+{
+    size_t i;
+    while ((i = _next_task.fetch_add(1)) < _num_tasks)
+        (*_task)(i);
+}
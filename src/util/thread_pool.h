@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running the tasks of a parallel loop. The calling thread
+// takes part in the loop, so a pool of N threads only spawns N-1 workers.
+class ThreadPool
+{
+
+private:
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _start_cv;
+    std::condition_variable _done_cv;
+
+    // Current loop (only changed while no worker is running)
+    const std::function<void(size_t)> *_task = nullptr;
+    size_t _num_tasks = 0;
+    std::atomic<size_t> _next_task{0};
+    // Incremented for each loop, so that the workers know when a new one starts
+    uint64_t _generation = 0;
+    int _num_running_workers = 0;
+    bool _stop = false;
+
+    void workerLoop();
+    void runTasks();
+
+public:
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Call task(i) for each i in [0, num_tasks) and return once all the calls are done.
+    // The tasks are picked in increasing order by the available threads.
+    void parallelFor(size_t num_tasks, const std::function<void(size_t)> &task);
+
+    int getNumThreads() const
+    {
+        return _workers.size() + 1;
+    }
+};
+
+#endif // THREAD_POOL_H